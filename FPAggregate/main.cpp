@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FPAccumulator.hpp"
+#include "FPValue.hpp"
+
+
+/*! 処理済みのページを解放する間隔（バイト数） */
+static const size_t kReleaseChunkSize = 64 * 1024 * 1024;
+
+/*!
+    1つのグループの集計結果を表す構造体です。
+ */
+struct AggregateStats
+{
+    /*! 数値の個数 */
+    unsigned long long  count;
+
+    /*! 合計 */
+    FPAccumulator       sum;
+
+    /*! 最小値 */
+    FPValue             min;
+
+    /*! 最大値 */
+    FPValue             max;
+
+    AggregateStats()
+        : count(0)
+    {}
+
+    /*! 数値を1つ集計に加えます。 */
+    void Add(const FPValue& value)
+    {
+        if (count == 0) {
+            min = value;
+            max = value;
+        } else if (FPValue::Compare(value, min) < 0) {
+            min = value;
+        } else if (FPValue::Compare(value, max) > 0) {
+            max = value;
+        }
+        sum += value;
+        count++;
+    }
+};
+
+/*!
+    コマンドラインで指定された設定です。
+ */
+struct AggregateOptions
+{
+    /*! 数値の列番号（0始まり） */
+    int         valueColumn;
+
+    /*! グループ化に使う列番号（0始まり）。グループ化しない場合は-1 */
+    int         keyColumn;
+
+    /*! 区切り文字 */
+    char        delimiter;
+
+    /*! 先頭行をヘッダとして読み飛ばすかどうか */
+    bool        hasHeader;
+
+    /*! 平均値を計算する小数点以下の桁数 */
+    int         meanDP;
+
+    /*! 入力ファイルのパス */
+    const char  *path;
+};
+
+/*!
+    使い方を表示します。
+ */
+static void PrintUsage(const char *command)
+{
+    fprintf(stderr, "Usage: %s [-c column] [-g column] [-d delimiter] [-t] [-H] [-p dp] file\n", command);
+    fprintf(stderr, "  -c column     column number of the values (1-origin, default: 1)\n");
+    fprintf(stderr, "  -g column     column number of the grouping key (1-origin)\n");
+    fprintf(stderr, "  -d delimiter  field delimiter (default: ',', or tab for *.tsv)\n");
+    fprintf(stderr, "  -t            use tab as the field delimiter\n");
+    fprintf(stderr, "  -H            skip the first line as a header\n");
+    fprintf(stderr, "  -p dp         decimal places of the mean (default: 10)\n");
+}
+
+/*!
+    行の中から指定された列のフィールドを探します。
+    @return フィールドが見つかればtrue
+ */
+static bool FindField(const char *line, const char *lineEnd, char delimiter, int column, const char *& fieldBegin, const char *& fieldEnd)
+{
+    const char *p = line;
+    for (int i = 0; i < column; i++) {
+        const char *next = (const char *)memchr(p, delimiter, lineEnd - p);
+        if (!next) {
+            return false;
+        }
+        p = next + 1;
+    }
+    const char *end = (const char *)memchr(p, delimiter, lineEnd - p);
+    fieldBegin = p;
+    fieldEnd = end? end: lineEnd;
+
+    // 前後の空白と引用符を取り除く
+    while (fieldBegin < fieldEnd && (*fieldBegin == ' ' || *fieldBegin == '"')) {
+        fieldBegin++;
+    }
+    while (fieldEnd > fieldBegin && (fieldEnd[-1] == ' ' || fieldEnd[-1] == '"' || fieldEnd[-1] == '\r')) {
+        fieldEnd--;
+    }
+    return true;
+}
+
+/*!
+    集計結果を1行出力します。
+ */
+static void PrintStats(const std::string *key, const AggregateStats& stats, int meanDP)
+{
+    if (key) {
+        printf("%s\t", key->c_str());
+    }
+    if (stats.count == 0) {
+        printf("0\t0\t\t\t\n");
+        return;
+    }
+    FPValue sum = stats.sum.Result();
+    FPValue mean = FPValue::Div(sum, FPValue(std::to_string(stats.count)), meanDP, true);
+    printf("%llu\t%s\t%s\t%s\t%s\n", stats.count, sum.c_str(), stats.min.c_str(), stats.max.c_str(), mean.c_str());
+}
+
+/*!
+    ファイルをメモリマップして、1回の走査で集計します。
+ */
+static int Aggregate(const AggregateOptions& options)
+{
+    int fd = open(options.path, O_RDONLY);
+    if (fd < 0) {
+        perror(options.path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(options.path);
+        close(fd);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = nullptr;
+    if (size > 0) {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            perror(options.path);
+            close(fd);
+            return 1;
+        }
+        data = (const char *)mapped;
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    AggregateStats total;
+    std::unordered_map<std::string, AggregateStats> groups;
+    std::string key;
+    unsigned long long lineCount = 0;
+    unsigned long long skippedCount = 0;
+    unsigned long long invalidCount = 0;
+    size_t releasedPos = 0;
+
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end) {
+        const char *lineEnd = (const char *)memchr(p, '\n', end - p);
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        lineCount++;
+
+        if (!(options.hasHeader && lineCount == 1)) {
+            const char *valueBegin;
+            const char *valueEnd;
+            if (!FindField(p, lineEnd, options.delimiter, options.valueColumn, valueBegin, valueEnd) || valueBegin == valueEnd) {
+                skippedCount++;
+            } else {
+                try {
+                    FPValue value(valueBegin, valueEnd - valueBegin);
+                    if (options.keyColumn >= 0) {
+                        const char *keyBegin;
+                        const char *keyEnd;
+                        if (FindField(p, lineEnd, options.delimiter, options.keyColumn, keyBegin, keyEnd)) {
+                            key.assign(keyBegin, keyEnd - keyBegin);
+                        } else {
+                            key.clear();
+                        }
+                        groups[key].Add(value);
+                    } else {
+                        total.Add(value);
+                    }
+                } catch (std::runtime_error& e) {
+                    invalidCount++;
+                }
+            }
+        }
+        p = (lineEnd < end)? (lineEnd + 1): end;
+
+        // 処理済みのページを解放して、メモリ使用量を一定に保つ
+        size_t pos = p - data;
+        if (pos - releasedPos >= kReleaseChunkSize && pos < size) {
+            size_t releaseEnd = pos & ~(size_t)(getpagesize() - 1);
+            madvise((void *)(data + releasedPos), releaseEnd - releasedPos, MADV_DONTNEED);
+            releasedPos = releaseEnd;
+        }
+    }
+
+    if (data) {
+        munmap((void *)data, size);
+    }
+
+    // 結果の出力
+    if (options.keyColumn >= 0) {
+        std::vector<std::string> keys;
+        keys.reserve(groups.size());
+        for (auto it = groups.begin(); it != groups.end(); ++it) {
+            keys.push_back(it->first);
+        }
+        std::sort(keys.begin(), keys.end());
+        printf("key\tcount\tsum\tmin\tmax\tmean\n");
+        for (size_t i = 0; i < keys.size(); i++) {
+            PrintStats(&keys[i], groups[keys[i]], options.meanDP);
+        }
+    } else {
+        printf("count\tsum\tmin\tmax\tmean\n");
+        PrintStats(nullptr, total, options.meanDP);
+    }
+    if (skippedCount > 0 || invalidCount > 0) {
+        fprintf(stderr, "skipped %llu empty and %llu invalid fields\n", skippedCount, invalidCount);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    AggregateOptions options;
+    options.valueColumn = 0;
+    options.keyColumn = -1;
+    options.delimiter = 0;
+    options.hasHeader = false;
+    options.meanDP = 10;
+    options.path = nullptr;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:g:d:tHp:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                options.valueColumn = atoi(optarg) - 1;
+                break;
+            case 'g':
+                options.keyColumn = atoi(optarg) - 1;
+                break;
+            case 'd':
+                options.delimiter = optarg[0];
+                break;
+            case 't':
+                options.delimiter = '\t';
+                break;
+            case 'H':
+                options.hasHeader = true;
+                break;
+            case 'p':
+                options.meanDP = atoi(optarg);
+                break;
+            default:
+                PrintUsage(argv[0]);
+                return (opt == 'h')? 0: 1;
+        }
+    }
+    if (optind != argc - 1 || options.valueColumn < 0 || options.meanDP < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    options.path = argv[optind];
+
+    // 区切り文字の指定がない場合は拡張子から判断する
+    if (options.delimiter == 0) {
+        size_t len = strlen(options.path);
+        options.delimiter = (len >= 4 && strcmp(options.path + len - 4, ".tsv") == 0)? '\t': ',';
+    }
+
+    try {
+        return Aggregate(options);
+    } catch (std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
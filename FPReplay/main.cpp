@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "FPMath.hpp"
+#include "FPTrace.hpp"
+#include "FPValue.hpp"
+
+
+/*!
+    1種類の演算の実行時間を集計する構造体です。
+ */
+struct OpStats
+{
+    /*! 実行し直したときの実行時間（ナノ秒） */
+    std::vector<uint64_t>   replayNanos;
+
+    /*! 記録したときの実行時間（ナノ秒） */
+    std::vector<uint64_t>   recordedNanos;
+
+    /*! 例外が投げられた回数 */
+    unsigned long long      errorCount;
+
+    OpStats()
+        : errorCount(0)
+    {}
+};
+
+/*!
+    使い方を表示します。
+ */
+static void PrintUsage(const char *command)
+{
+    fprintf(stderr, "Usage: %s [-r repeat] [-o op] trace\n", command);
+    fprintf(stderr, "  -r repeat     run each operation this many times and take the fastest (default: 1)\n");
+    fprintf(stderr, "  -o op         replay only the operations with this name (e.g. Mult)\n");
+}
+
+/*!
+    演算に必要な引数の個数を取得します（配列を引数にとる演算は0）。
+ */
+static size_t RequiredOperandCount(FPTraceOp op)
+{
+    switch (op) {
+        case FPTraceOp_Add:
+        case FPTraceOp_Sub:
+        case FPTraceOp_Mult:
+        case FPTraceOp_Div:
+        case FPTraceOp_DivMod:
+        case FPTraceOp_Pow:
+            return 2;
+        case FPTraceOp_LogBaseE:
+        case FPTraceOp_Pi:
+        case FPTraceOp_SinBatch:
+        case FPTraceOp_CosBatch:
+        case FPTraceOp_ExpBatch:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/*!
+    記録した1回の演算を実行します。演算の結果は捨てます。
+ */
+static void Execute(const FPTraceRecord& record)
+{
+    const std::vector<FPValue>& v = record.operands;
+    if (v.size() < RequiredOperandCount(record.op)) {
+        throw std::runtime_error("Too few operands.");
+    }
+    // 壊れた記録の値で、各関数のassertに引っかからないようにする
+    bool hasDP = (record.op != FPTraceOp_Add && record.op != FPTraceOp_Sub && record.op != FPTraceOp_Mult);
+    if (hasDP && record.dp < 0) {
+        throw std::runtime_error("Invalid decimal places.");
+    }
+    if (record.op == FPTraceOp_DivMod && (record.aux < RoundMode_HalfUp || record.aux > RoundMode_HalfEven)) {
+        throw std::runtime_error("Invalid round mode.");
+    }
+    switch (record.op) {
+        case FPTraceOp_Add:
+            FPValue::Add(v[0], v[1]);
+            break;
+        case FPTraceOp_Sub:
+            FPValue::Sub(v[0], v[1]);
+            break;
+        case FPTraceOp_Mult:
+            FPValue::Mult(v[0], v[1]);
+            break;
+        case FPTraceOp_Div:
+            FPValue::Div(v[0], v[1], record.dp, record.aux != 0);
+            break;
+        case FPTraceOp_DivMod:
+            FPValue::DivMod(v[0], v[1], record.dp, (RoundMode)record.aux);
+            break;
+        case FPTraceOp_LogBaseE:
+            FPMath::LogBaseE(record.dp);
+            break;
+        case FPTraceOp_Pi:
+            FPMath::Pi(record.dp);
+            break;
+        case FPTraceOp_Sin:
+            FPMath::Sin(v[0], record.dp);
+            break;
+        case FPTraceOp_Cos:
+            FPMath::Cos(v[0], record.dp);
+            break;
+        case FPTraceOp_Pow:
+            FPMath::Pow(v[0], v[1], record.dp);
+            break;
+        case FPTraceOp_Sqrt:
+            FPMath::Sqrt(v[0], record.dp);
+            break;
+        case FPTraceOp_Root:
+            FPMath::Root(v[0], record.aux, record.dp);
+            break;
+        case FPTraceOp_Log:
+            FPMath::Log(v[0], record.dp);
+            break;
+        case FPTraceOp_Exp:
+            FPMath::Exp(v[0], record.dp);
+            break;
+        case FPTraceOp_SinBatch:
+            FPMath::SinBatch(v, record.dp);
+            break;
+        case FPTraceOp_CosBatch:
+            FPMath::CosBatch(v, record.dp);
+            break;
+        case FPTraceOp_ExpBatch:
+            FPMath::ExpBatch(v, record.dp);
+            break;
+        default:
+            throw std::runtime_error("Unknown operation.");
+    }
+}
+
+/*!
+    昇順に並べた実行時間の、指定した割合の位置の値（マイクロ秒）を求めます。
+ */
+static double PercentileMicros(const std::vector<uint64_t>& sorted, double ratio)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = std::min(sorted.size() - 1, (size_t)(ratio * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = 1;
+    std::string opFilter;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:o:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 'o':
+                opFilter = optarg;
+                break;
+            default:
+                PrintUsage(argv[0]);
+                return (opt == 'h')? 0: 1;
+        }
+    }
+    if (optind != argc - 1 || repeat < 1) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // 環境変数で記録が有効になっていても、実行し直す演算は記録しない
+    FPTrace::Stop();
+
+    std::vector<FPTraceRecord> records;
+    try {
+        records = FPTrace::ReadFile(argv[optind]);
+    } catch (std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    // 各演算を実行し直して、最も速かった時間を集計する
+    std::vector<OpStats> stats(FPTraceOp_End);
+    for (const FPTraceRecord& record : records) {
+        if (opFilter.length() > 0 && opFilter != FPTrace::OpName(record.op)) {
+            continue;
+        }
+        OpStats& s = stats[record.op];
+        s.recordedNanos.push_back(record.nanos);
+        uint64_t best = UINT64_MAX;
+        try {
+            for (int i = 0; i < repeat; i++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                Execute(record);
+                std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+            s.replayNanos.push_back(best);
+        } catch (std::exception&) {
+            s.errorCount++;
+        }
+    }
+
+    // 演算ごとの実行時間の分布（マイクロ秒）
+    printf("%-9s %9s %6s %11s %11s %11s %11s %11s %11s %12s\n",
+           "op", "count", "errors", "p50", "p90", "p99", "max", "mean", "rec p50", "total ms");
+    for (int op = 1; op < FPTraceOp_End; op++) {
+        OpStats& s = stats[op];
+        if (s.recordedNanos.empty()) {
+            continue;
+        }
+        std::sort(s.replayNanos.begin(), s.replayNanos.end());
+        std::sort(s.recordedNanos.begin(), s.recordedNanos.end());
+        double total = 0;
+        for (uint64_t nanos : s.replayNanos) {
+            total += nanos;
+        }
+        double mean = s.replayNanos.empty()? 0: (total / s.replayNanos.size() / 1000.0);
+        printf("%-9s %9zu %6llu %11.2f %11.2f %11.2f %11.2f %11.2f %11.2f %12.3f\n",
+               FPTrace::OpName((FPTraceOp)op), s.recordedNanos.size(), s.errorCount,
+               PercentileMicros(s.replayNanos, 0.5), PercentileMicros(s.replayNanos, 0.9),
+               PercentileMicros(s.replayNanos, 0.99), PercentileMicros(s.replayNanos, 1.0),
+               mean, PercentileMicros(s.recordedNanos, 0.5), total / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "FPTuning.hpp"
+#include "IntLimbsHelper.hpp"
+#include "IntStringHelper.hpp"
+
+
+/*! 境目の値を使わないことを表す大きな値 */
+static const int kNeverThreshold = 1 << 30;
+
+/*! 計測に使う乱数生成器 */
+static std::mt19937_64 sRandom(20260419);
+
+/*!
+    1つの境目の値を計測するための設定です。
+    アルゴリズムは、計測する大きさnが境目の値以上のときに新しい（大きな数向けの）方法に切り替わるものとします。
+ */
+struct TuningTarget
+{
+    /*! プロファイルのキー名（表示用） */
+    const char  *name;
+
+    /*! 計測する大きさの一覧（昇順） */
+    std::vector<int>    sizes;
+
+    /*! 境目の値をプロファイルに設定する関数 */
+    std::function<void(FPTuningProfile& profile, int threshold)> setThreshold;
+
+    /*! 大きさnの計測用の処理を作成する関数 */
+    std::function<std::function<void()>(int n)> makeWork;
+
+    /*! 境目の値に許される最大値 */
+    int         maxThreshold = kNeverThreshold;
+};
+
+/*!
+    使い方を表示します。
+ */
+static void PrintUsage(const char *command)
+{
+    fprintf(stderr, "Usage: %s [-o path] [-t millis] [-n]\n", command);
+    fprintf(stderr, "  -o path       profile to write (default: $FPVALUE_TUNING_PROFILE or ~/.fpvalue_tuning)\n");
+    fprintf(stderr, "  -t millis     minimum time of each measurement (default: 20)\n");
+    fprintf(stderr, "  -n            print the measured profile without writing it\n");
+}
+
+/*!
+    n個のリムからなる乱数を作成します（最上位のリムは0以外）。
+ */
+static IntLimbs RandomLimbs(int n)
+{
+    IntLimbs ret(n);
+    for (int i = 0; i < n; i++) {
+        ret[i] = (uint32_t)sRandom();
+    }
+    ret[n-1] |= 1;
+    return ret;
+}
+
+/*!
+    n桁の整数文字列の乱数を作成します。
+ */
+static std::string RandomDigits(int n)
+{
+    std::string ret(1, (char)('1' + sRandom() % 9));
+    for (int i = 1; i < n; i++) {
+        ret += (char)('0' + sRandom() % 10);
+    }
+    return ret;
+}
+
+/*!
+    処理1回あたりの時間（秒）を計測します。合計の時間がminSeconds以上になるまで、回数を倍々に増やして繰り返します。
+ */
+static double MeasureSeconds(const std::function<void()>& work, double minSeconds)
+{
+    work();
+    for (long count = 1; ; count *= 2) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (long i = 0; i < count; i++) {
+            work();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= minSeconds) {
+            return elapsed / count;
+        }
+    }
+}
+
+/*!
+    境目の値を計測します。各大きさnについて、古い方法（境目をn+1にした場合）と新しい方法（境目をnにした場合）の時間を比べ、
+    その大きさ以上では常に新しい方法の方が速くなる最小のnを境目とします。
+    @param profile  計測中に使うプロファイル。結果の境目の値を設定してリターンします。
+ */
+static void Tune(const TuningTarget& target, FPTuningProfile& profile, double minSeconds)
+{
+    std::vector<bool> isNewFaster;
+    for (int n : target.sizes) {
+        std::function<void()> work = target.makeWork(n);
+        target.setThreshold(profile, n + 1);
+        FPTuning::Set(profile);
+        double oldTime = MeasureSeconds(work, minSeconds);
+        target.setThreshold(profile, n);
+        FPTuning::Set(profile);
+        double newTime = MeasureSeconds(work, minSeconds);
+        isNewFaster.push_back(newTime < oldTime);
+        printf("  %-22s n=%-6d old %12.3f us  new %12.3f us\n", target.name, n, oldTime * 1e6, newTime * 1e6);
+    }
+
+    // 大きい方から見て、新しい方法が続けて速い範囲の最小の大きさを境目とする
+    int threshold = target.sizes.back() * 2;
+    for (size_t i = target.sizes.size(); i > 0 && isNewFaster[i-1]; i--) {
+        threshold = target.sizes[i-1];
+    }
+    threshold = std::min(threshold, target.maxThreshold);
+    target.setThreshold(profile, threshold);
+    FPTuning::Set(profile);
+    printf("%s=%d\n", target.name, threshold);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *envPath = getenv("FPVALUE_TUNING_PROFILE");
+    std::string path = (envPath && envPath[0] != '\0')? std::string(envPath): FPTuning::DefaultPath();
+    double minSeconds = 0.02;
+    bool isDryRun = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:t:nh")) != -1) {
+        switch (opt) {
+            case 'o':
+                path = optarg;
+                break;
+            case 't':
+                minSeconds = atoi(optarg) / 1000.0;
+                break;
+            case 'n':
+                isDryRun = true;
+                break;
+            default:
+                PrintUsage(argv[0]);
+                return (opt == 'h')? 0: 1;
+        }
+    }
+    if (optind != argc || minSeconds <= 0 || (!isDryRun && path.length() == 0)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // 既存のプロファイルに影響されないように、デフォルト値から計測を始める
+    FPTuningProfile profile;
+    FPTuning::Set(profile);
+
+    // SIMD実装の筆算の掛け算（Karatsuba法を使わない状態で計測する）
+    int karatsubaLimbs = profile.karatsubaLimbs;
+    profile.karatsubaLimbs = kNeverThreshold;
+    TuningTarget simdTarget = {
+        "simd_mult_min_limbs",
+        { 1, 2, 3, 4, 6, 8, 12, 16, 24 },
+        [](FPTuningProfile& p, int t) { p.simdMultMinLimbs = t; },
+        [](int n) {
+            IntLimbs a = RandomLimbs(n), b = RandomLimbs(n);
+            return std::function<void()>([a, b]() { IntLimbs_Mult(a, b); });
+        },
+    };
+    Tune(simdTarget, profile, minSeconds);
+    profile.karatsubaLimbs = karatsubaLimbs;
+
+    // Karatsuba法の掛け算
+    TuningTarget karatsubaTarget = {
+        "karatsuba_limbs",
+        { 8, 12, 16, 24, 32, 48, 64, 96, 128 },
+        [](FPTuningProfile& p, int t) { p.karatsubaLimbs = t; },
+        [](int n) {
+            IntLimbs a = RandomLimbs(n), b = RandomLimbs(n);
+            return std::function<void()>([a, b]() { IntLimbs_Mult(a, b); });
+        },
+    };
+    Tune(karatsubaTarget, profile, minSeconds);
+
+    // 10進文字列とリム配列の変換（往復の時間を計測する）
+    TuningTarget convTarget = {
+        "conv_base_digits",
+        { 16, 32, 64, 128, 256, 512, 1024 },
+        [](FPTuningProfile& p, int t) { p.convBaseDigits = t - 1; },
+        [](int n) {
+            std::string digits = RandomDigits(n);
+            return std::function<void()>([digits]() { IntString_FromLimbs(IntString_ToLimbs(digits)); });
+        },
+    };
+    Tune(convTarget, profile, minSeconds);
+
+    // リム配列の割り算（2nリム÷nリム）
+    TuningTarget newtonTarget = {
+        "div_newton_min_limbs",
+        { 8, 16, 32, 64, 128, 192, 256, 384, 512, 768, 1024 },
+        [](FPTuningProfile& p, int t) { p.divNewtonMinLimbs = t; },
+        [](int n) {
+            IntLimbs a = RandomLimbs(2 * n), b = RandomLimbs(n);
+            return std::function<void()>([a, b]() { IntLimbs_DivMod(a, b); });
+        },
+    };
+    Tune(newtonTarget, profile, minSeconds);
+
+    // 整数文字列の掛け算（n桁×64桁。短い方を1つのintで掛ける筆算は8桁までなので、境目は9以下にする）
+    TuningTarget limbsMultTarget = {
+        "limbs_mult_min_digits",
+        { 1, 2, 3, 4, 5, 6, 7, 8 },
+        [](FPTuningProfile& p, int t) { p.limbsMultMinDigits = t; },
+        [](int n) {
+            std::string a = RandomDigits(n), b = RandomDigits(64);
+            return std::function<void()>([a, b]() { IntString_Mult(a, b); });
+        },
+        9,
+    };
+    Tune(limbsMultTarget, profile, minSeconds);
+
+    // 整数文字列の割り算（n桁÷n/2桁）
+    TuningTarget divTarget = {
+        "div_limbs_min_digits",
+        { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64 },
+        [](FPTuningProfile& p, int t) { p.divLimbsMinDigits = t; },
+        [](int n) {
+            std::string a = RandomDigits(n), b = RandomDigits((n + 1) / 2);
+            return std::function<void()>([a, b]() { IntString_Div(a, b); });
+        },
+    };
+    Tune(divTarget, profile, minSeconds);
+
+    if (isDryRun) {
+        return 0;
+    }
+    try {
+        FPTuning::Save(path, profile);
+    } catch (std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    printf("wrote %s\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,493 @@
+#include "DoubleHelper.hpp"
+#include "IntLimbsHelper.hpp"
+#include "IntStringHelper.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+
+/*! Ryuで使う5の累乗の逆数の表の大きさ */
+static const int kPow5InvTableSize = 342;
+
+/*! Ryuで使う5の累乗の表の大きさ */
+static const int kPow5TableSize = 326;
+
+/*! Ryuの表の値のビット数 */
+static const int kPow5BitCount = 125;
+
+/*! Ryuの表の値のビット数（逆数） */
+static const int kPow5InvBitCount = 125;
+
+/*! 誤差なくdoubleで表せる10の累乗 */
+static const double kExactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*! 10の累乗（uint64_tに収まるもの） */
+static const uint64_t kIntPowersOfTen[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+/*!
+    Ryuで使う5の累乗とその逆数の上位125ビットの表です。
+ */
+struct Pow5Tables
+{
+    /*! floor(2^(pow5bits(q)-1+125) / 5^q) + 1 を、下位64ビット・上位64ビットの順に格納したもの */
+    uint64_t    inv[kPow5InvTableSize][2];
+
+    /*! 5^iの上位125ビットを、下位64ビット・上位64ビットの順に格納したもの */
+    uint64_t    pow[kPow5TableSize][2];
+};
+
+
+/*!
+    正の有限の値を m × 2^e2 （mは奇数）に分解します。
+ */
+static uint64_t Decompose(double value, int& e2)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biasedExp = (int)((bits >> 52) & 0x7FF);
+    uint64_t m = bits & ((1ull << 52) - 1);
+    if (biasedExp == 0) {
+        e2 = -1074;
+    } else {
+        m |= (1ull << 52);
+        e2 = biasedExp - 1075;
+    }
+    int zeros = __builtin_ctzll(m);
+    e2 += zeros;
+    return m >> zeros;
+}
+
+/*!
+    2^127未満の符号なし整数を10進数の文字列に変換します。
+ */
+static std::string UInt128ToString(unsigned __int128 value)
+{
+    uint64_t high = (uint64_t)(value / kIntPowersOfTen[19]);
+    uint64_t low = (uint64_t)(value % kIntPowersOfTen[19]);
+    if (high == 0) {
+        return std::to_string(low);
+    }
+    std::string lowStr = std::to_string(low);
+    return std::to_string(high) + std::string(19 - lowStr.length(), '0') + lowStr;
+}
+
+/*!
+    リム配列のビット数を求めます。
+ */
+static int BitLength(const IntLimbs& limbs)
+{
+    return (limbs.size() == 0)? 0: (int)(limbs.size() * 32 - __builtin_clz(limbs.back()));
+}
+
+/*!
+    2のn乗を表すリム配列を作成します。
+ */
+static IntLimbs PowerOfTwo(int n)
+{
+    IntLimbs ret(n / 32, 0);
+    ret.push_back(1u << (n % 32));
+    return ret;
+}
+
+/*!
+    リム配列の[shift, shift+128)ビット目を取り出します。shiftが負の場合は左にずらした値になります。
+    @param sticky   shiftより下のビットに1があればtrueを格納します（NULLでも構いません）
+ */
+static unsigned __int128 ExtractBits128(const IntLimbs& limbs, int shift, bool *sticky)
+{
+    if (shift < 0) {
+        unsigned __int128 value = ExtractBits128(limbs, 0, sticky);
+        return value << -shift;
+    }
+    size_t index = shift / 32;
+    int offset = shift % 32;
+    unsigned __int128 window = 0;
+    for (size_t i = 0; i < 4 && index + i < limbs.size(); i++) {
+        window |= (unsigned __int128)limbs[index + i] << (32 * i);
+    }
+    window >>= offset;
+    if (offset > 0 && index + 4 < limbs.size()) {
+        window |= (unsigned __int128)limbs[index + 4] << (128 - offset);
+    }
+    if (sticky) {
+        bool isNonZero = (offset > 0 && index < limbs.size() && (limbs[index] & ((1u << offset) - 1)) != 0);
+        for (size_t i = 0; i < index && i < limbs.size() && !isNonZero; i++) {
+            isNonZero = (limbs[i] != 0);
+        }
+        *sticky = isNonZero;
+    }
+    return window;
+}
+
+/*!
+    5^eのビット数（e >= 0、e = 0のときは1）を求めます。
+ */
+static int Pow5Bits(int e)
+{
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/*!
+    floor(e * log10(2)) を求めます。
+ */
+static int Log10Pow2(int e)
+{
+    return (int)(((uint32_t)e * 78913) >> 18);
+}
+
+/*!
+    floor(e * log10(5)) を求めます。
+ */
+static int Log10Pow5(int e)
+{
+    return (int)(((uint32_t)e * 732923) >> 20);
+}
+
+/*!
+    Ryuで使う表を多倍長整数で計算します。
+ */
+static Pow5Tables ComputePow5Tables()
+{
+    Pow5Tables tables;
+    IntLimbs pow5(1, 1);
+    for (int i = 0; i < kPow5InvTableSize; i++) {
+        int bits = Pow5Bits(i);
+        assert(bits == BitLength(pow5));
+        if (i < kPow5TableSize) {
+            unsigned __int128 value = ExtractBits128(pow5, bits - kPow5BitCount, nullptr);
+            tables.pow[i][0] = (uint64_t)value;
+            tables.pow[i][1] = (uint64_t)(value >> 64);
+        }
+        IntLimbs inv = IntLimbs_DivMod(PowerOfTwo(bits - 1 + kPow5InvBitCount), pow5).first;
+        unsigned __int128 value = ExtractBits128(inv, 0, nullptr) + 1;
+        tables.inv[i][0] = (uint64_t)value;
+        tables.inv[i][1] = (uint64_t)(value >> 64);
+        pow5 = IntLimbs_Mult(pow5, IntLimbs(1, 5));
+    }
+    return tables;
+}
+
+/*!
+    Ryuで使う表を取得します。最初の呼び出しで計算します。
+ */
+static const Pow5Tables& GetPow5Tables()
+{
+    static const Pow5Tables tables = ComputePow5Tables();
+    return tables;
+}
+
+/*!
+    (m × mul) >> j を計算します（mulは128ビット、j >= 64）。
+ */
+static inline uint64_t MulShift64(uint64_t m, const uint64_t *mul, int j)
+{
+    unsigned __int128 low = (unsigned __int128)m * mul[0];
+    unsigned __int128 high = (unsigned __int128)m * mul[1];
+    return (uint64_t)(((low >> 64) + high) >> (j - 64));
+}
+
+/*!
+    数値が5で何回割り切れるかを数えます。
+ */
+static inline int Pow5Factor(uint64_t value)
+{
+    int count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count;
+}
+
+/*!
+    q × 2^e2 を、最も近いdoubleの値に丸めます（真ん中の値は偶数の方に丸めます）。
+    @param q        仮数（0以外）
+    @param e2       2進指数
+    @param sticky   qより下に0でない端数があるかどうか
+ */
+static double RoundToDouble(uint64_t q, int e2, bool sticky)
+{
+    // 残す最下位のビットの位置（非正規化数では2^-1074に固定）
+    int bitLength = 64 - __builtin_clzll(q);
+    int lowest = std::max(bitLength - 1 + e2 - 52, -1074);
+    int shift = lowest - e2;
+    uint64_t mantissa;
+    bool roundBit, restBits;
+    if (shift <= 0) {
+        mantissa = q << -shift;
+        roundBit = false;
+        restBits = sticky;
+    } else if (shift > 64) {
+        mantissa = 0;
+        roundBit = false;
+        restBits = true;
+    } else {
+        mantissa = (shift == 64)? 0: (q >> shift);
+        roundBit = ((q >> (shift - 1)) & 1) != 0;
+        restBits = sticky || (shift > 1 && (q & ((1ull << (shift - 1)) - 1)) != 0);
+    }
+    if (roundBit && (restBits || (mantissa & 1) != 0)) {
+        mantissa++;
+    }
+    return ldexp((double)mantissa, lowest);
+}
+
+
+// 誤差のない10進数への展開
+void Double_ExactDigits(double value, std::string& digits, int& exponent)
+{
+    // value = m × 2^e2（mは奇数）なので、末尾に0が付くことはない
+    int e2 = 0;
+    uint64_t m = Decompose(value, e2);
+    if (e2 >= 0) {
+        exponent = 0;
+        if (e2 + (64 - __builtin_clzll(m)) <= 127) {
+            digits = UInt128ToString((unsigned __int128)m << e2);
+        } else {
+            IntLimbs ret(e2 / 32, 0);
+            unsigned __int128 shifted = (unsigned __int128)m << (e2 % 32);
+            while (shifted > 0) {
+                ret.push_back((uint32_t)shifted);
+                shifted >>= 32;
+            }
+            digits = IntString_FromLimbs(ret);
+        }
+        return;
+    }
+
+    // m × 2^-k = (m × 5^k) × 10^-k
+    int k = -e2;
+    exponent = e2;
+    unsigned __int128 product = m;
+    int done = 0;
+    while (done < k && (product >> 124) == 0) {
+        product *= 5;
+        done++;
+    }
+    if (done == k) {
+        digits = UInt128ToString(product);
+        return;
+    }
+    IntLimbs limbs;
+    while (m > 0) {
+        limbs.push_back((uint32_t)m);
+        m >>= 32;
+    }
+    static const uint32_t kPow5_13 = 1220703125;
+    for (; k >= 13; k -= 13) {
+        limbs = IntLimbs_Mult(limbs, IntLimbs(1, kPow5_13));
+    }
+    uint32_t rest = 1;
+    for (; k > 0; k--) {
+        rest *= 5;
+    }
+    limbs = IntLimbs_Mult(limbs, IntLimbs(1, rest));
+    digits = IntString_FromLimbs(limbs);
+}
+
+// 最も短い10進数への変換（Ryu）
+void Double_ShortestDigits(double value, uint64_t& digits, int& exponent)
+{
+    const Pow5Tables& tables = GetPow5Tables();
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biasedExp = (int)((bits >> 52) & 0x7FF);
+    uint64_t mantissaBits = bits & ((1ull << 52) - 1);
+
+    // 値を m2 × 2^e2 とし、前後の値との中点を含む範囲 [mm, mp] × 2^(e2-2) を考える
+    int e2;
+    uint64_t m2;
+    if (biasedExp == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = mantissaBits;
+    } else {
+        e2 = biasedExp - 1023 - 52 - 2;
+        m2 = (1ull << 52) | mantissaBits;
+    }
+    bool acceptBounds = ((m2 & 1) == 0);
+    uint64_t mv = 4 * m2;
+    uint32_t mmShift = (mantissaBits != 0 || biasedExp <= 1)? 1: 0;
+
+    // 範囲の両端と値を10進数に変換する（vm, vr, vp × 10^e10）
+    uint64_t vr, vp, vm;
+    int e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    if (e2 >= 0) {
+        int q = Log10Pow2(e2) - (e2 > 3);
+        e10 = q;
+        int k = kPow5InvBitCount + Pow5Bits(q) - 1;
+        int i = -e2 + q + k;
+        vr = MulShift64(4 * m2, tables.inv[q], i);
+        vp = MulShift64(4 * m2 + 2, tables.inv[q], i);
+        vm = MulShift64(4 * m2 - 1 - mmShift, tables.inv[q], i);
+        if (q <= 21) {
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = (Pow5Factor(mv) >= q);
+            } else if (acceptBounds) {
+                vmIsTrailingZeros = (Pow5Factor(mv - 1 - mmShift) >= q);
+            } else {
+                vp -= (Pow5Factor(mv + 2) >= q)? 1: 0;
+            }
+        }
+    } else {
+        int q = Log10Pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        int i = -e2 - q;
+        int k = Pow5Bits(i) - kPow5BitCount;
+        int j = q - k;
+        vr = MulShift64(4 * m2, tables.pow[i], j);
+        vp = MulShift64(4 * m2 + 2, tables.pow[i], j);
+        vm = MulShift64(4 * m2 - 1 - mmShift, tables.pow[i], j);
+        if (q <= 1) {
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = (mmShift == 1);
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vrIsTrailingZeros = ((mv & ((1ull << q) - 1)) == 0);
+        }
+    }
+
+    // 範囲に収まる限り下の桁を取り除く
+    int removed = 0;
+    uint64_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        // 範囲の端や真ん中の値にちょうど一致する可能性がある場合
+        int lastRemovedDigit = 0;
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= (vm % 10 == 0);
+            vrIsTrailingZeros &= (lastRemovedDigit == 0);
+            lastRemovedDigit = (int)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                lastRemovedDigit = (int)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            // ちょうど真ん中の場合は偶数の方に丸める
+            lastRemovedDigit = 4;
+        }
+        output = vr + (((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5)? 1: 0);
+    } else {
+        // ほとんどの場合はこちら
+        bool roundUp = false;
+        if (vp / 100 > vm / 100) {
+            roundUp = (vr % 100 >= 50);
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            roundUp = (vr % 10 >= 5);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + ((vr == vm || roundUp)? 1: 0);
+    }
+    exponent = e10 + removed;
+
+    // 末尾の0は指数に移す
+    while (output % 10 == 0) {
+        output /= 10;
+        exponent++;
+    }
+    digits = output;
+}
+
+// 10進数からdoubleへの変換
+double Double_FromDigits(const char *digits, size_t count, int exponent)
+{
+    // 先頭と末尾の0を取り除く
+    size_t begin = 0;
+    while (begin < count && digits[begin] == '0') {
+        begin++;
+    }
+    if (begin == count) {
+        return 0.0;
+    }
+    size_t end = count;
+    long exp10 = exponent;
+    while (digits[end - 1] == '0') {
+        end--;
+        exp10++;
+    }
+    size_t n = end - begin;
+
+    // 範囲外（値は10^(exp10+n-1)以上10^(exp10+n)未満）
+    if (exp10 + (long)n - 1 > 308) {
+        return HUGE_VAL;
+    }
+    if (exp10 + (long)n < -324) {
+        return 0.0;
+    }
+
+    // 数字列と10の累乗が誤差なくdoubleで表せる場合は、演算1回で正しく丸めた値が求まる
+    if (n <= 19) {
+        uint64_t w = 0;
+        for (size_t i = begin; i < end; i++) {
+            w = w * 10 + (uint64_t)(digits[i] - '0');
+        }
+        if (w <= (1ull << 53)) {
+            if (exp10 >= 0 && exp10 <= 22) {
+                return (double)w * kExactPowersOfTen[exp10];
+            }
+            if (exp10 < 0 && exp10 >= -22) {
+                return (double)w / kExactPowersOfTen[-exp10];
+            }
+            if (exp10 > 22 && exp10 <= 22 + 15 && w <= (1ull << 53) / kIntPowersOfTen[exp10 - 22]) {
+                return (double)(w * kIntPowersOfTen[exp10 - 22]) * kExactPowersOfTen[22];
+            }
+        }
+    }
+
+    // 多倍長整数で、64ビット前後の商と端数の有無を求めてから丸める
+    IntLimbs value = IntString_ToLimbs(std::string(digits + begin, n));
+    uint64_t q;
+    int e2;
+    bool sticky;
+    if (exp10 >= 0) {
+        value = IntLimbs_Mult(value, IntString_ToLimbs("1" + std::string(exp10, '0')));
+        int shift = std::max(BitLength(value) - 64, 0);
+        q = (uint64_t)ExtractBits128(value, shift, &sticky);
+        e2 = shift;
+    } else {
+        IntLimbs divisor = IntString_ToLimbs("1" + std::string(-exp10, '0'));
+        int shift = BitLength(divisor) - BitLength(value) + 63;
+        if (shift >= 0) {
+            value = IntLimbs_Mult(value, PowerOfTwo(shift));
+        } else {
+            divisor = IntLimbs_Mult(divisor, PowerOfTwo(-shift));
+        }
+        std::pair<IntLimbs, IntLimbs> qr = IntLimbs_DivMod(value, divisor);
+        q = (uint64_t)ExtractBits128(qr.first, 0, nullptr);
+        sticky = (qr.second.size() > 0);
+        e2 = -shift;
+    }
+    return RoundToDouble(q, e2, sticky);
+}
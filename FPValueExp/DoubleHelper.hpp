@@ -0,0 +1,40 @@
+#ifndef DoubleHelper_hpp
+#define DoubleHelper_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+    倍精度浮動小数点数（double）と10進数の数字列との変換を行う関数群です。
+    数値は「数字列 × 10^exponent」の形で表し、数字列には符号や小数点を含めません。
+ */
+
+/*!
+    正の有限のdoubleの値を、誤差のない10進数に展開します（2進数の値はすべて有限桁の10進数で表せます）。
+    @param value    正の有限の値
+    @param digits   数字列を格納する文字列（末尾に0は付きません）
+    @param exponent 10進指数を格納する変数
+ */
+void Double_ExactDigits(double value, std::string& digits, int& exponent);
+
+/*!
+    正の有限のdoubleの値を、読み戻すと同じ値になる最も短い10進数に変換します（Ryuのアルゴリズム）。
+    最も短い桁数の候補が複数ある場合は、元の値に最も近いものを選びます。
+    @param value    正の有限の値
+    @param digits   最大17桁の数字列を表す整数を格納する変数（末尾に0は付きません）
+    @param exponent 10進指数を格納する変数
+ */
+void Double_ShortestDigits(double value, uint64_t& digits, int& exponent);
+
+/*!
+    「数字列 × 10^exponent」を、最も近いdoubleの値に変換します（真ん中の値は偶数の方に丸めます）。
+    有効数字が19桁以下で誤差なく計算できる場合は浮動小数点数の演算1回で、それ以外は多倍長整数で計算します。
+    @param digits   数字列の先頭（先頭に0が付いていても構いません）
+    @param count    数字列の長さ
+    @param exponent 10進指数
+    @return 変換した正の値（大きすぎる場合は無限大、小さすぎる場合は0）
+ */
+double Double_FromDigits(const char *digits, size_t count, int exponent);
+
+#endif /* DoubleHelper_hpp */
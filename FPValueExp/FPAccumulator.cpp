@@ -0,0 +1,204 @@
+#include "FPAccumulator.hpp"
+
+#include <algorithm>
+
+
+/*! 1つのリムが表す10進数の桁数 */
+static const int kLimbDigits = 9;
+
+/*! リムの基数 */
+static const int64_t kLimbBase = 1000000000;
+
+/*! 正規化せずに足し込める回数の上限（2^33 × 10^9 < 2^63） */
+static const uint64_t kMaxPendingCount = (uint64_t)1 << 33;
+
+/*! 10のべき乗の表 */
+static const int64_t kPow10[kLimbDigits + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+
+/*!
+    下のリムから桁上がりを伝播させます。
+    最上位以外のリムは[0, 10^9)に収まり、最上位のリムだけが符号を持ちます。
+ */
+static void PropagateCarries(std::vector<int64_t>& limbs)
+{
+    int64_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); i++) {
+        int64_t v = limbs[i] + carry;
+        carry = v / kLimbBase;
+        v -= carry * kLimbBase;
+        if (v < 0) {
+            v += kLimbBase;
+            carry--;
+        }
+        limbs[i] = v;
+    }
+    while (carry <= -kLimbBase || carry >= kLimbBase) {
+        limbs.push_back(carry % kLimbBase);
+        carry /= kLimbBase;
+    }
+    if (carry != 0) {
+        limbs.push_back(carry);
+    }
+
+    // 最上位の不要な0を削除する
+    while (limbs.size() > 0 && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
+
+
+// コンストラクタ
+FPAccumulator::FPAccumulator()
+    : fracLimbs(0), pendingCount(0)
+{}
+
+// 小数部のリムを増やす
+void FPAccumulator::ReserveDecimalPlaces(int dp)
+{
+    int needLimbs = (dp + kLimbDigits - 1) / kLimbDigits;
+    if (needLimbs > fracLimbs) {
+        // 必要な個数の倍まで確保して、挿入の回数を抑える
+        int addLimbs = std::max(needLimbs - fracLimbs, fracLimbs);
+        limbs.insert(limbs.begin(), addLimbs, 0);
+        fracLimbs += addLimbs;
+    }
+}
+
+// 整数部のリムを増やす
+void FPAccumulator::ReserveIntegerPlaces(int topPlace)
+{
+    size_t needLimbs = (size_t)(fracLimbs + topPlace / kLimbDigits + 1);
+    if (limbs.size() < needLimbs) {
+        limbs.resize(needLimbs, 0);
+    }
+}
+
+// 符号を指定して数字列を足し込む
+void FPAccumulator::AddDigits(int sign, const std::string& vstr, int dp)
+{
+    int len = (int)vstr.length();
+    if (len == 0 || (len == 1 && vstr[0] == '0')) {
+        return;
+    }
+    if (pendingCount >= kMaxPendingCount) {
+        Normalize();
+    }
+    ReserveDecimalPlaces(dp);
+    ReserveIntegerPlaces(len - 1 - dp);
+
+    // 最下位の桁から順に、対応するリムに足し込む
+    int pos = fracLimbs * kLimbDigits - dp;
+    size_t index = (size_t)(pos / kLimbDigits);
+    int shift = pos % kLimbDigits;
+    int64_t chunk = 0;
+    for (int i = len - 1; i >= 0; i--) {
+        chunk += (vstr[i] - '0') * kPow10[shift];
+        if (++shift == kLimbDigits) {
+            limbs[index++] += sign * chunk;
+            chunk = 0;
+            shift = 0;
+        }
+    }
+    if (chunk != 0) {
+        limbs[index] += sign * chunk;
+    }
+    pendingCount++;
+}
+
+// 数値を足し込む
+void FPAccumulator::Add(const FPValue& value)
+{
+    AddDigits(value.sign, value.vstr, value.dp);
+}
+
+// 数値を引く
+void FPAccumulator::Sub(const FPValue& value)
+{
+    AddDigits(-value.sign, value.vstr, value.dp);
+}
+
+// 別のアキュムレータの合計を足し込む
+void FPAccumulator::Merge(const FPAccumulator& other)
+{
+    if (other.limbs.size() == 0) {
+        return;
+    }
+    if (pendingCount + other.pendingCount > kMaxPendingCount) {
+        Normalize();
+        if (pendingCount + other.pendingCount > kMaxPendingCount) {
+            FPAccumulator normalized(other);
+            normalized.Normalize();
+            Merge(normalized);
+            return;
+        }
+    }
+
+    // 小数点の位置を揃えて、リムごとに足し合わせる
+    ReserveDecimalPlaces(other.fracLimbs * kLimbDigits);
+    size_t offset = (size_t)(fracLimbs - other.fracLimbs);
+    if (limbs.size() < offset + other.limbs.size()) {
+        limbs.resize(offset + other.limbs.size(), 0);
+    }
+    for (size_t i = 0; i < other.limbs.size(); i++) {
+        limbs[offset + i] += other.limbs[i];
+    }
+    pendingCount += other.pendingCount;
+}
+
+// 合計を0に戻す
+void FPAccumulator::Clear()
+{
+    limbs.clear();
+    fracLimbs = 0;
+    pendingCount = 0;
+}
+
+// 桁上がりを処理して正規化する
+void FPAccumulator::Normalize()
+{
+    PropagateCarries(limbs);
+    if (limbs.size() < (size_t)fracLimbs) {
+        limbs.resize(fracLimbs, 0);
+    }
+    pendingCount = (limbs.size() > 0)? 1: 0;
+}
+
+// 現在の合計を取得する
+FPValue FPAccumulator::Result() const
+{
+    std::vector<int64_t> work(limbs);
+    PropagateCarries(work);
+    if (work.size() == 0) {
+        return FPValue();
+    }
+
+    // 最上位のリムが負の場合は、全体の符号を反転してから正規化し直す
+    int sign = 1;
+    if (work.back() < 0) {
+        sign = -1;
+        for (size_t i = 0; i < work.size(); i++) {
+            work[i] = -work[i];
+        }
+        PropagateCarries(work);
+    }
+    if (work.size() < (size_t)fracLimbs) {
+        work.resize(fracLimbs, 0);
+    }
+
+    // 上のリムから10進数の文字列にする
+    std::string vstr;
+    vstr.reserve(work.size() * kLimbDigits);
+    char buf[kLimbDigits + 1];
+    for (size_t i = work.size(); i-- > 0;) {
+        int64_t v = work[i];
+        for (int j = kLimbDigits - 1; j >= 0; j--) {
+            buf[j] = (char)('0' + v % 10);
+            v /= 10;
+        }
+        vstr.append(buf, kLimbDigits);
+    }
+    return FPValue(sign, vstr, fracLimbs * kLimbDigits);
+}
@@ -0,0 +1,65 @@
+#ifndef FPAccumulator_hpp
+#define FPAccumulator_hpp
+
+#include "FPValue.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+/*!
+    多数の数値の合計を誤差なく求めるためのアキュムレータです。
+    小数点の位置を揃えた10^9進数の符号付きリムの配列に、桁上がりを処理せずに値を足し込んでいきます（キャリー・セーブ）。
+    桁上がりの処理と正規化はResult()の呼び出し時（または必要になった時）にだけ行うので、
+    1つの数値の追加にかかる時間はその数値の桁数に比例します。
+ */
+class FPAccumulator
+{
+    /*! リムの配列（下の桁から順に格納する）。各リムは10^9進数の1桁を表す */
+    std::vector<int64_t>    limbs;
+
+    /*! 小数部に割り当てたリムの個数 */
+    int                     fracLimbs;
+
+    /*! 前回の正規化以降に足し込んだ回数（各リムの絶対値はこの回数×10^9未満） */
+    uint64_t                pendingCount;
+
+    /*! 小数点以下の桁数がdpの値を受け入れられるように、小数部のリムを増やします。 */
+    void    ReserveDecimalPlaces(int dp);
+
+    /*! 最上位の桁がtopPlace（10^topPlaceの位）の値を受け入れられるように、整数部のリムを増やします。 */
+    void    ReserveIntegerPlaces(int topPlace);
+
+    /*! 符号を指定して、数字列を足し込みます。 */
+    void    AddDigits(int sign, const std::string& vstr, int dp);
+
+public:
+    /*! コンストラクタ。合計0の状態から始めます。 */
+    FPAccumulator();
+
+public:
+    /*! 数値を足し込みます。 */
+    void    Add(const FPValue& value);
+
+    /*! 数値を引きます。 */
+    void    Sub(const FPValue& value);
+
+    /*! 別のアキュムレータの合計を足し込みます。 */
+    void    Merge(const FPAccumulator& other);
+
+    /*! 合計を0に戻します。 */
+    void    Clear();
+
+    /*! 桁上がりを処理して、各リムを正規化します。合計の値は変わりません。 */
+    void    Normalize();
+
+    /*! 現在の合計を取得します。 */
+    FPValue Result() const;
+
+public:
+    FPAccumulator&  operator+=(const FPValue& value) { Add(value); return *this; }
+    FPAccumulator&  operator-=(const FPValue& value) { Sub(value); return *this; }
+
+};
+
+#endif /* FPAccumulator_hpp */
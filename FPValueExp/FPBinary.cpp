@@ -0,0 +1,443 @@
+#include "FPBinary.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+
+/*! 1グループの数字の個数 */
+static const int kGroupDigits = 12;
+
+/*! 1グループのバイト数（10^12 < 2^40） */
+static const int kGroupBytes = 5;
+
+/*! 最上位のグループの桁数ごとのバイト数 */
+static const int kLeadBytes[kGroupDigits + 1] = { 0, 1, 1, 2, 2, 3, 3, 3, 4, 4, 5, 5, 5 };
+
+/*! ヘッダにそのまま格納できるdpの上限 */
+static const int kInlineDPLimit = 15;
+
+/*! 読み込むdpの絶対値の上限（ビューの加減算で桁の位置を計算してもintに収まる範囲） */
+static const int kMaxAbsDP = INT_MAX / 4;
+
+/*! 配列のヘッダのマジックナンバー */
+static const uint8_t kArrayMagic[3] = { 'F', 'P', 'B' };
+
+
+/*!
+    可変長整数（LEB128）を書き込みます。
+ */
+static void WriteVarint(uint64_t value, std::vector<uint8_t>& out)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+/*!
+    可変長整数（LEB128）を読み込みます。データが足りない場合は例外を投げます。
+ */
+static uint64_t ReadVarint(const uint8_t *& p, const uint8_t *end)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) {
+            throw std::runtime_error("Truncated FPBinary data.");
+        }
+        uint8_t b = *p++;
+        value |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in FPBinary data.");
+}
+
+/*!
+    符号付きの整数を、絶対値の小さい数ほど短くなるように符号なしの整数に変換します（ジグザグ符号化）。
+ */
+static uint64_t ZigZagEncode(int value)
+{
+    return ((uint64_t)(int64_t)value << 1) ^ (uint64_t)((int64_t)value >> 63);
+}
+
+/*!
+    ジグザグ符号化した整数を元に戻します。
+ */
+static int64_t ZigZagDecode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/*!
+    n桁の数字列の、最上位のグループの桁数を求めます。
+ */
+static int LeadDigits(int n)
+{
+    return n - kGroupDigits * ((n - 1) / kGroupDigits);
+}
+
+/*!
+    n桁の数字列を格納するのに必要なバイト数を求めます。
+ */
+static size_t DigitBytes(int n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    return kLeadBytes[LeadDigits(n)] + (size_t)((n - 1) / kGroupDigits) * kGroupBytes;
+}
+
+/*!
+    リトルエンディアンで格納されたグループの値を読み込みます。
+ */
+static uint64_t ReadGroup(const uint8_t *p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/*!
+    詰め込んだ数字列を、上の桁から順に1つずつ読み出すクラスです。
+ */
+class ForwardDigitReader
+{
+    const uint8_t   *p;
+    int             remainGroups;
+    bool            isFirst;
+    int             leadDigits;
+    char            buf[kGroupDigits];
+    int             bufPos;
+    int             bufLen;
+
+public:
+    ForwardDigitReader(const uint8_t *digits, int n)
+        : p(digits), remainGroups((n > 0)? ((n - 1) / kGroupDigits + 1): 0), isFirst(true),
+          leadDigits((n > 0)? LeadDigits(n): 0), bufPos(0), bufLen(0)
+    {}
+
+    /*! 次の数字を読み出します。数字がもうない場合は0をリターンします。 */
+    int Next()
+    {
+        if (bufPos == bufLen) {
+            if (remainGroups == 0) {
+                return 0;
+            }
+            int len = isFirst? leadDigits: kGroupDigits;
+            int bytes = isFirst? kLeadBytes[len]: kGroupBytes;
+            uint64_t value = ReadGroup(p, bytes);
+            for (int i = len - 1; i >= 0; i--) {
+                buf[i] = (char)(value % 10);
+                value /= 10;
+            }
+            p += bytes;
+            isFirst = false;
+            remainGroups--;
+            bufPos = 0;
+            bufLen = len;
+        }
+        return buf[bufPos++];
+    }
+};
+
+/*!
+    詰め込んだ数字列を、下の桁から順に1つずつ読み出すクラスです。
+ */
+class ReverseDigitReader
+{
+    const uint8_t   *digits;
+    int             group;
+    int             leadDigits;
+    uint64_t        value;
+    int             remainInGroup;
+
+public:
+    ReverseDigitReader(const uint8_t *_digits, int n)
+        : digits(_digits), group((n > 0)? ((n - 1) / kGroupDigits + 1): 0),
+          leadDigits((n > 0)? LeadDigits(n): 0), value(0), remainInGroup(0)
+    {}
+
+    /*! 次の数字を読み出します。数字がもうない場合は0をリターンします。 */
+    int Next()
+    {
+        if (remainInGroup == 0) {
+            if (group == 0) {
+                return 0;
+            }
+            group--;
+            if (group == 0) {
+                value = ReadGroup(digits, kLeadBytes[leadDigits]);
+                remainInGroup = leadDigits;
+            } else {
+                value = ReadGroup(digits + kLeadBytes[leadDigits] + (size_t)(group - 1) * kGroupBytes, kGroupBytes);
+                remainInGroup = kGroupDigits;
+            }
+        }
+        int d = (int)(value % 10);
+        value /= 10;
+        remainInGroup--;
+        return d;
+    }
+};
+
+
+const uint8_t FPBinary::Version;
+
+
+// 1つの数値をバイナリ形式に変換する
+void FPBinary::Encode(const FPValue& value, std::vector<uint8_t>& out)
+{
+    // 先頭の0を除いた数字列
+    const std::string& vstr = value.vstr;
+    int len = (int)vstr.length();
+    int top = 0;
+    while (top < len && vstr[top] == '0') {
+        top++;
+    }
+    int n = len - top;
+    int dp = (n > 0)? value.dp: 0;
+    int sign = (n > 0 && value.sign < 0)? 1: 0;
+
+    // ヘッダ（末尾の0を小数点の位置で表した整数のdpはマイナスなので、dpが15以上の場合と同じく続く可変長整数で表す）
+    bool isInlineDP = (dp >= 0 && dp < kInlineDPLimit);
+    uint64_t header = ((uint64_t)n << 5) | ((uint64_t)(isInlineDP? dp: kInlineDPLimit) << 1) | (uint64_t)sign;
+    WriteVarint(header, out);
+    if (!isInlineDP) {
+        WriteVarint(ZigZagEncode(dp - kInlineDPLimit), out);
+    }
+
+    // 数字列を上の桁のグループから順に格納する
+    int pos = top;
+    int groupLen = (n > 0)? LeadDigits(n): 0;
+    int bytes = (n > 0)? kLeadBytes[groupLen]: 0;
+    while (pos < len) {
+        uint64_t group = 0;
+        for (int i = 0; i < groupLen; i++) {
+            group = group * 10 + (uint64_t)(vstr[pos + i] - '0');
+        }
+        for (int i = 0; i < bytes; i++) {
+            out.push_back((uint8_t)(group >> (8 * i)));
+        }
+        pos += groupLen;
+        groupLen = kGroupDigits;
+        bytes = kGroupBytes;
+    }
+}
+
+// バイナリ形式の1つの数値を読み込む
+FPValue FPBinary::Decode(const uint8_t *data, size_t size, size_t *consumed)
+{
+    FPValueView view(data, size);
+    if (consumed) {
+        *consumed = view.ByteSize();
+    }
+    return view.ToFPValue();
+}
+
+// 数値の配列をヘッダ付きのバイナリ形式に変換する
+std::vector<uint8_t> FPBinary::EncodeArray(const std::vector<FPValue>& values)
+{
+    std::vector<uint8_t> out(kArrayMagic, kArrayMagic + 3);
+    out.push_back(Version);
+    WriteVarint(values.size(), out);
+    for (size_t i = 0; i < values.size(); i++) {
+        Encode(values[i], out);
+    }
+    return out;
+}
+
+// ヘッダ付きのバイナリ形式から数値の配列を読み込む
+std::vector<FPValue> FPBinary::DecodeArray(const uint8_t *data, size_t size)
+{
+    std::vector<FPValueView> views = ViewArray(data, size);
+    std::vector<FPValue> ret;
+    ret.reserve(views.size());
+    for (size_t i = 0; i < views.size(); i++) {
+        ret.push_back(views[i].ToFPValue());
+    }
+    return ret;
+}
+
+// ヘッダ付きのバイナリ形式の各数値を参照するビューの配列を作成する
+std::vector<FPValueView> FPBinary::ViewArray(const uint8_t *data, size_t size)
+{
+    if (size < 4 || !std::equal(kArrayMagic, kArrayMagic + 3, data)) {
+        throw std::runtime_error("Not an FPBinary array.");
+    }
+    if (data[3] != Version) {
+        throw std::runtime_error("Unsupported FPBinary version.");
+    }
+    const uint8_t *p = data + 4;
+    const uint8_t *end = data + size;
+    uint64_t count = ReadVarint(p, end);
+
+    std::vector<FPValueView> ret;
+    ret.reserve((size_t)std::min<uint64_t>(count, (uint64_t)(end - p)));
+    for (uint64_t i = 0; i < count; i++) {
+        FPValueView view(p, end - p);
+        p += view.ByteSize();
+        ret.push_back(view);
+    }
+    return ret;
+}
+
+
+// デフォルトコンストラクタ
+FPValueView::FPValueView()
+    : sign(1), digitCount(0), dp(0), digits(nullptr), byteSize(0)
+{}
+
+// コンストラクタ。ヘッダを読み込んでビューを作成する。
+FPValueView::FPValueView(const uint8_t *data, size_t size)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    uint64_t header = ReadVarint(p, end);
+    sign = (header & 1)? -1: 1;
+    dp = (int)((header >> 1) & 0x0f);
+    if ((header >> 5) > (uint64_t)INT_MAX) {
+        throw std::runtime_error("Malformed digit count in FPBinary data.");
+    }
+    digitCount = (int)(header >> 5);
+    if (dp == kInlineDPLimit) {
+        int64_t extra = ZigZagDecode(ReadVarint(p, end));
+        if (extra < -(int64_t)kMaxAbsDP - kInlineDPLimit || extra > (int64_t)kMaxAbsDP - kInlineDPLimit) {
+            throw std::runtime_error("Malformed decimal places in FPBinary data.");
+        }
+        dp += (int)extra;
+    }
+    digits = p;
+
+    // 数字列のバイト数は、桁数が残りのバイト数で収まる範囲であることを確かめてから計算する
+    size_t remainBytes = (size_t)(end - p);
+    if ((uint64_t)digitCount > (uint64_t)remainBytes * 3 || remainBytes < DigitBytes(digitCount)) {
+        throw std::runtime_error("Truncated FPBinary data.");
+    }
+    size_t digitBytes = DigitBytes(digitCount);
+    byteSize = (p - data) + digitBytes;
+}
+
+// FPValueへの変換
+FPValue FPValueView::ToFPValue() const
+{
+    if (digitCount == 0) {
+        return FPValue();
+    }
+    std::string vstr(digitCount, '0');
+    ForwardDigitReader reader(digits, digitCount);
+    for (int i = 0; i < digitCount; i++) {
+        vstr[i] = (char)('0' + reader.Next());
+    }
+    return FPValue(sign, vstr, dp);
+}
+
+// 2つの数値の絶対値の大小比較
+int FPValueView::AbsCompare(const FPValueView& value1, const FPValueView& value2)
+{
+    // どちらかがゼロの場合
+    if (value1.IsZero() || value2.IsZero()) {
+        return (value1.IsZero()? 0: 1) - (value2.IsZero()? 0: 1);
+    }
+
+    // 最上位の桁の位置が異なれば、それで大小が決まる
+    int top1 = value1.digitCount - 1 - value1.dp;
+    int top2 = value2.digitCount - 1 - value2.dp;
+    if (top1 != top2) {
+        return (top1 > top2)? 1: -1;
+    }
+
+    // 上の桁から大小比較していく
+    ForwardDigitReader reader1(value1.digits, value1.digitCount);
+    ForwardDigitReader reader2(value2.digits, value2.digitCount);
+    int count = std::max(value1.digitCount, value2.digitCount);
+    for (int i = 0; i < count; i++) {
+        int d1 = reader1.Next();
+        int d2 = reader2.Next();
+        if (d1 != d2) {
+            return (d1 > d2)? 1: -1;
+        }
+    }
+    return 0;
+}
+
+// 2つの数値の大小比較
+int FPValueView::Compare(const FPValueView& value1, const FPValueView& value2)
+{
+    if (value1.sign != value2.sign) {
+        return (value1.sign > 0)? 1: -1;
+    }
+    return AbsCompare(value1, value2) * value1.sign;
+}
+
+// 2つの数値の絶対値の足し算・引き算
+FPValue FPValueView::AddOrSubAbs(const FPValueView& value1, const FPValueView& value2, int sign, bool isSub)
+{
+    int dp = std::max(value1.dp, value2.dp);
+    int top = std::max(value1.digitCount - 1 - value1.dp, value2.digitCount - 1 - value2.dp);
+    int len = top + dp + 2;
+    std::string result(len, '0');
+
+    // 小数点の位置を合わせて、下の桁から順に計算する
+    ReverseDigitReader reader1(value1.digits, value1.digitCount);
+    ReverseDigitReader reader2(value2.digits, value2.digitCount);
+    int carry = 0;
+    for (int i = 0; i < len; i++) {
+        int place = i - dp;
+        int d1 = (place >= -value1.dp)? reader1.Next(): 0;
+        int d2 = (place >= -value2.dp)? reader2.Next(): 0;
+        int v = isSub? (d1 - d2 - carry): (d1 + d2 + carry);
+        if (isSub) {
+            carry = (v < 0)? 1: 0;
+            v += carry * 10;
+        } else {
+            carry = v / 10;
+            v -= carry * 10;
+        }
+        result[len - 1 - i] = (char)('0' + v);
+    }
+    return FPValue(sign, result, dp);
+}
+
+// 2つの数値の足し算
+FPValue FPValueView::Add(const FPValueView& value1, const FPValueView& value2)
+{
+    return AddSigned(value1, value1.sign, value2, value2.sign);
+}
+
+// 2つの数値の引き算
+FPValue FPValueView::Sub(const FPValueView& minuend, const FPValueView& subtrahend)
+{
+    return AddSigned(minuend, minuend.sign, subtrahend, -subtrahend.sign);
+}
+
+// 符号を指定した2つの数値の足し算
+FPValue FPValueView::AddSigned(const FPValueView& value1, int sign1, const FPValueView& value2, int sign2)
+{
+    // どちらかがゼロならば、もう一方の数値をそのままリターンする
+    if (value1.IsZero()) {
+        FPValue ret = value2.ToFPValue();
+        return (sign2 == value2.sign)? ret: ret.Negate();
+    } else if (value2.IsZero()) {
+        FPValue ret = value1.ToFPValue();
+        return (sign1 == value1.sign)? ret: ret.Negate();
+    }
+
+    // 符号が同じ場合は絶対値の足し算
+    if (sign1 == sign2) {
+        return AddOrSubAbs(value1, value2, sign1, false);
+    }
+
+    // 符号が異なる場合は、絶対値の大きい方から小さい方を引く
+    int comp = AbsCompare(value1, value2);
+    if (comp == 0) {
+        return FPValue();
+    } else if (comp > 0) {
+        return AddOrSubAbs(value1, value2, sign1, true);
+    }
+    return AddOrSubAbs(value2, value1, sign2, true);
+}
@@ -0,0 +1,129 @@
+#ifndef FPBinary_hpp
+#define FPBinary_hpp
+
+#include "FPValue.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+class FPValueView;
+
+
+/*!
+    FPValueのコンパクトなバイナリ形式への変換を行う関数群です。
+
+    1つの数値は、可変長整数（LEB128）のヘッダと、詰め込んだ数字列からなります。
+    - ヘッダ: (数字の個数 << 5) | (dpフィールド << 1) | (負の数なら1)。dpが0〜14の場合はdpフィールドにそのまま格納し、
+      それ以外（15以上か、末尾の0を小数点の位置で表した整数のマイナスのdp）の場合はdpフィールドを15にして、続けて(dp - 15)をジグザグ符号化した可変長整数で格納します。
+    - 数字列: 先頭の0を除いた数字を下の桁から12桁ずつに区切り、各グループを40ビット（5バイト、リトルエンディアン）の整数として、上の桁のグループから順に格納します。
+      最上位のグループだけは桁数に応じた最小のバイト数（1〜5バイト）で格納します。
+    配列はマジックナンバー"FPB"とバージョン番号、要素数のヘッダに続けて各数値を並べた形式です。
+ */
+struct FPBinary
+{
+    /*! バイナリ形式のバージョン番号 */
+    static const uint8_t    Version = 2;
+
+    /*! 1つの数値をバイナリ形式に変換して、outの末尾に追加します。 */
+    static void     Encode(const FPValue& value, std::vector<uint8_t>& out);
+
+    /*!
+        バイナリ形式の1つの数値を読み込みます。形式が正しくない場合は例外を投げます。
+        @param data     読み込む位置
+        @param size     読み込めるバイト数
+        @param consumed 読み込んだバイト数を格納する変数（NULLでも構いません）
+     */
+    static FPValue  Decode(const uint8_t *data, size_t size, size_t *consumed);
+
+    /*! 数値の配列を、ヘッダ付きのバイナリ形式に変換します。 */
+    static std::vector<uint8_t> EncodeArray(const std::vector<FPValue>& values);
+
+    /*! ヘッダ付きのバイナリ形式から、数値の配列を読み込みます。形式が正しくない場合は例外を投げます。 */
+    static std::vector<FPValue> DecodeArray(const uint8_t *data, size_t size);
+
+    /*!
+        ヘッダ付きのバイナリ形式の各数値を参照するビューの配列を作成します。
+        数値はコピーされないので、ビューを使っている間はdataを解放してはいけません。
+     */
+    static std::vector<FPValueView> ViewArray(const uint8_t *data, size_t size);
+
+};
+
+
+/*!
+    バイナリ形式の数値を、コピーせずにそのまま参照する読み取り専用のビューです。
+    メモリマップしたバッファの上で、std::stringを作らずに比較や加減算を行うことができます。
+ */
+class FPValueView
+{
+    /*! 符号を表す数値。1か-1 */
+    int             sign;
+
+    /*! 数字の個数（先頭の0を含まない） */
+    int             digitCount;
+
+    /*! 小数点以下の数字の個数（末尾の0を小数点の位置で表した整数ではマイナス） */
+    int             dp;
+
+    /*! 詰め込んだ数字列の先頭 */
+    const uint8_t   *digits;
+
+    /*! ヘッダを含めたバイト数 */
+    size_t          byteSize;
+
+    /*! 絶対値の足し算（isSub=falseのとき）か引き算（isSub=trueのとき）を計算し、signの符号を付けます。引き算の場合は|value1| >= |value2|である必要があります。 */
+    static FPValue  AddOrSubAbs(const FPValueView& value1, const FPValueView& value2, int sign, bool isSub);
+
+    /*! 符号を指定した2つの数値の足し算を計算します。 */
+    static FPValue  AddSigned(const FPValueView& value1, int sign1, const FPValueView& value2, int sign2);
+
+public:
+    /*! 2つの数値の絶対値の大小比較を行います。 */
+    static int      AbsCompare(const FPValueView& value1, const FPValueView& value2);
+
+    /*! 2つの数値の大小比較を行います。 */
+    static int      Compare(const FPValueView& value1, const FPValueView& value2);
+
+    /*! 2つの数値の足し算を計算します。 */
+    static FPValue  Add(const FPValueView& value1, const FPValueView& value2);
+
+    /*! 2つの数値の引き算を計算します。 */
+    static FPValue  Sub(const FPValueView& minuend, const FPValueView& subtrahend);
+
+public:
+    /*! デフォルトコンストラクタ。数値0を表すビューを作成します。 */
+    FPValueView();
+
+    /*!
+        コンストラクタ。バイナリ形式の1つの数値のヘッダを読み込んでビューを作成します。形式が正しくない場合は例外を投げます。
+        @param data     読み込む位置
+        @param size     読み込めるバイト数
+     */
+    FPValueView(const uint8_t *data, size_t size);
+
+public:
+    /*! ヘッダを含めたバイト数を取得します。 */
+    size_t  ByteSize() const { return byteSize; }
+
+    /*! 数値の符号（1か-1）を取得します。 */
+    int     Sign() const { return sign; }
+
+    /*! 数字の個数を取得します。 */
+    int     DigitCount() const { return digitCount; }
+
+    /*! 小数点以下の数字の個数を取得します（末尾の0を小数点の位置で表した整数ではマイナス）。 */
+    int     DecimalPlaces() const { return dp; }
+
+    /*! この数値がゼロかどうかを判定します。 */
+    bool    IsZero() const { return digitCount == 0; }
+
+    /*! この数値をFPValueに変換します。 */
+    FPValue ToFPValue() const;
+
+public:
+    friend struct FPBinary;
+
+};
+
+#endif /* FPBinary_hpp */
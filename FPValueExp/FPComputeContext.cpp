@@ -0,0 +1,91 @@
+#include "FPComputeContext.hpp"
+
+
+/*! 現在のスレッドに関連付けられたコンテキスト */
+static thread_local FPComputeContext *sCurrentContext = nullptr;
+
+
+// 現在のスレッドのコンテキスト
+FPComputeContext *FPComputeContext::Current()
+{
+    return sCurrentContext;
+}
+
+// キャンセルと期限の確認
+void FPComputeContext::CheckPoint()
+{
+    FPComputeContext *context = sCurrentContext;
+    if (!context) {
+        return;
+    }
+    if (context->isCancelled.load(std::memory_order_relaxed)) {
+        throw FPComputeCancelled("Computation was cancelled.");
+    }
+    if (context->hasDeadline && std::chrono::steady_clock::now() >= context->deadline) {
+        throw FPComputeCancelled("Computation deadline exceeded.");
+    }
+}
+
+// 進み具合の記録
+void FPComputeContext::ReportProgress(uint64_t terms, int digits)
+{
+    FPComputeContext *context = sCurrentContext;
+    if (!context) {
+        return;
+    }
+    context->termsDone.store(terms, std::memory_order_relaxed);
+    context->estimatedDigits.store(digits, std::memory_order_relaxed);
+}
+
+// 現在のスレッドへの関連付け
+FPComputeContext::Scope::Scope(FPComputeContext *context)
+    : previous(sCurrentContext)
+{
+    sCurrentContext = context;
+}
+
+// 元の関連付けに戻す
+FPComputeContext::Scope::~Scope()
+{
+    sCurrentContext = previous;
+}
+
+// コンストラクタ
+FPComputeContext::FPComputeContext()
+    : isCancelled(false), hasDeadline(false), termsDone(0), estimatedDigits(0), targetDigits(0)
+{}
+
+// キャンセルの要求
+void FPComputeContext::Cancel()
+{
+    isCancelled.store(true, std::memory_order_relaxed);
+}
+
+// キャンセルが要求されたかどうか
+bool FPComputeContext::IsCancelled() const
+{
+    return isCancelled.load(std::memory_order_relaxed);
+}
+
+// 期限の設定
+void FPComputeContext::SetDeadline(std::chrono::steady_clock::time_point time)
+{
+    hasDeadline = true;
+    deadline = time;
+}
+
+// 目標とする桁数の設定
+void FPComputeContext::SetTargetDigits(int digits)
+{
+    targetDigits = digits;
+}
+
+// 進み具合の取得
+FPProgress FPComputeContext::Progress() const
+{
+    FPProgress progress;
+    progress.termsDone = termsDone.load(std::memory_order_relaxed);
+    progress.estimatedDigits = estimatedDigits.load(std::memory_order_relaxed);
+    progress.targetDigits = targetDigits;
+    return progress;
+}
@@ -0,0 +1,112 @@
+#ifndef FPComputeContext_hpp
+#define FPComputeContext_hpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+
+/*!
+    計算がキャンセルされたか、期限を過ぎたときに投げられる例外です。
+ */
+class FPComputeCancelled : public std::runtime_error
+{
+public:
+    explicit FPComputeCancelled(const char *message)
+        : std::runtime_error(message)
+    {}
+};
+
+/*!
+    計算の進み具合を表す構造体です。
+ */
+struct FPProgress
+{
+    /*! 計算済みの級数の項数（ニュートン法の場合は反復回数） */
+    uint64_t    termsDone;
+
+    /*! 確定したと見込まれる小数点以下の桁数 */
+    int         estimatedDigits;
+
+    /*! 目標とする小数点以下の桁数 */
+    int         targetDigits;
+};
+
+/*!
+    長時間かかる計算のキャンセル・期限・進み具合を管理するコンテキストです。
+    Scopeを使って実行中のスレッドに関連付けると、FPMathの級数のループやFPValue::Divの割り算のループの中で
+    CheckPoint()によってキャンセルと期限が確認され、FPComputeCancelledが投げられます。
+    コンテキストが関連付けられていないスレッドでは、CheckPoint()とReportProgress()は何もしません。
+ */
+class FPComputeContext
+{
+    /*! キャンセルが要求されたかどうか */
+    std::atomic<bool>       isCancelled;
+
+    /*! 期限が設定されているかどうか */
+    bool                    hasDeadline;
+
+    /*! 期限 */
+    std::chrono::steady_clock::time_point deadline;
+
+    /*! 計算済みの項数 */
+    std::atomic<uint64_t>   termsDone;
+
+    /*! 確定したと見込まれる桁数 */
+    std::atomic<int>        estimatedDigits;
+
+    /*! 目標とする桁数 */
+    int                     targetDigits;
+
+public:
+    /*! 現在のスレッドに関連付けられたコンテキストを取得します。関連付けられていなければNULLをリターンします。 */
+    static FPComputeContext *Current();
+
+    /*! 現在のスレッドのコンテキストがキャンセルされているか期限を過ぎていれば、FPComputeCancelledを投げます。 */
+    static void CheckPoint();
+
+    /*! 現在のスレッドのコンテキストに、計算の進み具合を記録します。 */
+    static void ReportProgress(uint64_t terms, int digits);
+
+public:
+    /*!
+        コンテキストを現在のスレッドに関連付けるためのクラスです。デストラクタで元の関連付けに戻します。
+     */
+    class Scope
+    {
+        FPComputeContext    *previous;
+
+    public:
+        explicit Scope(FPComputeContext *context);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+public:
+    /*! コンストラクタ。期限なしのコンテキストを作成します。 */
+    FPComputeContext();
+
+    FPComputeContext(const FPComputeContext&) = delete;
+    FPComputeContext& operator=(const FPComputeContext&) = delete;
+
+public:
+    /*! キャンセルを要求します。どのスレッドから呼び出しても構いません。 */
+    void        Cancel();
+
+    /*! キャンセルが要求されたかどうかを判定します。 */
+    bool        IsCancelled() const;
+
+    /*! 期限を設定します。計算を開始する前に設定してください。 */
+    void        SetDeadline(std::chrono::steady_clock::time_point time);
+
+    /*! 目標とする桁数を設定します。 */
+    void        SetTargetDigits(int digits);
+
+    /*! 計算の進み具合を取得します。どのスレッドから呼び出しても構いません。 */
+    FPProgress  Progress() const;
+
+};
+
+#endif /* FPComputeContext_hpp */
@@ -0,0 +1,270 @@
+#include "FPDigitStream.hpp"
+#include "IntStringHelper.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+
+/*! 1回に計算する小数点以下の桁数の最小値 */
+static const size_t kMinChunkDigits = 32;
+
+
+/*!
+    10のn乗を表すリム配列を作成します。
+ */
+static IntLimbs PowerOfTen(size_t n)
+{
+    return IntString_ToLimbs("1" + std::string(n, '0'));
+}
+
+/*!
+    リム配列を下位のnリム分だけ右にずらします（2^(32n)で割って切り捨てます）。
+ */
+static IntLimbs ShiftRightLimbs(const IntLimbs& limbs, size_t n)
+{
+    if (n >= limbs.size()) {
+        return IntLimbs();
+    }
+    return IntLimbs(limbs.begin() + n, limbs.end());
+}
+
+/*!
+    定数の級数の第j項と第(j-1)項の比 p/q を取得します。
+    円周率は j/(2j+1)、自然対数の底は 1/j で、どちらも j >= 2 では1/2以下になります。
+ */
+static void SeriesRatio(bool isPi, uint32_t j, uint32_t& p, uint32_t& q)
+{
+    p = isPi? j: 1;
+    q = isPi? (2 * j + 1): j;
+}
+
+/*!
+    級数の第n1項から第(n2-1)項までを、binary splittingでまとめます。
+    P, Qは項の比の分子・分母の積、Tは 第(n1-1)項を1としたときの第n1項から第(n2-1)項までの和にQを掛けたものです。
+ */
+static void SplitSeries(bool isPi, uint32_t n1, uint32_t n2, IntLimbs& P, IntLimbs& Q, IntLimbs& T)
+{
+    assert(n1 < n2);
+    if (n2 - n1 == 1) {
+        uint32_t p, q;
+        SeriesRatio(isPi, n1, p, q);
+        P = IntLimbs(1, p);
+        Q = IntLimbs(1, q);
+        T = P;
+        return;
+    }
+
+    uint32_t mid = n1 + (n2 - n1) / 2;
+    IntLimbs P1, Q1, T1, P2, Q2, T2;
+    SplitSeries(isPi, n1, mid, P1, Q1, T1);
+    SplitSeries(isPi, mid, n2, P2, Q2, T2);
+    T = IntLimbs_Add(IntLimbs_Mult(T1, Q2), IntLimbs_Mult(P1, T2));
+    P = IntLimbs_Mult(P1, P2);
+    Q = IntLimbs_Mult(Q1, Q2);
+}
+
+/*!
+    小数点以下digitCount桁を求めるのに必要な級数の項の数の見積もりを計算します。
+    残りの項の和は最後に含めた項以下なので、その項が10^-(digitCount+2)より小さくなるまで含めます。
+ */
+static uint32_t SeriesTermsForDigits(bool isPi, size_t digitCount)
+{
+    double target = (double)digitCount + 2;
+    if (isPi) {
+        // 項の比は1/2未満
+        return (uint32_t)std::ceil(target * 3.3219280948873623) + 2;
+    }
+    // 第j項は1/j!
+    double log10Sum = 0;
+    uint32_t j = 1;
+    while (log10Sum <= target) {
+        j++;
+        log10Sum += std::log10((double)j);
+    }
+    return j + 1;
+}
+
+
+// 種類を指定したコンストラクタ
+FPDigitStream::FPDigitStream(Kind kind)
+    : kind(kind), sign(1), intPart("0"), isExact(false), position(0), termCount(1)
+{
+}
+
+// 商のストリームを作成する
+FPDigitStream FPDigitStream::Quotient(const FPValue& dividend, const FPValue& divisor)
+{
+    if (divisor.IsZero()) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+
+    // (X / 10^xdp) / (Y / 10^ydp) = (X * 10^(ydp - xdp)) / Y なので、10の累乗は割られる数か割る数の小さい方に掛ける
+    FPDigitStream stream(Kind_Quotient);
+    int shift = divisor.dp - dividend.dp;
+    std::string numStr = dividend.vstr;
+    std::string denStr = divisor.vstr;
+    if (shift >= 0) {
+        numStr.append(shift, '0');
+    } else {
+        denStr.append(-shift, '0');
+    }
+    stream.den = IntString_ToLimbs(denStr);
+
+    std::pair<IntLimbs, IntLimbs> div = IntLimbs_DivMod(IntString_ToLimbs(IntString_Normalize(numStr)), stream.den);
+    stream.intPart = IntString_FromLimbs(div.first);
+    stream.remain = div.second;
+    stream.isExact = (stream.remain.size() == 0);
+    stream.sign = (dividend.IsZero())? 1: dividend.sign * divisor.sign;
+    return stream;
+}
+
+// 円周率のストリームを作成する
+FPDigitStream FPDigitStream::Pi()
+{
+    FPDigitStream stream(Kind_Pi);
+    stream.seriesP = IntLimbs(1, 1);
+    stream.seriesQ = IntLimbs(1, 1);
+    stream.Extend(1);
+    return stream;
+}
+
+// 自然対数の底のストリームを作成する
+FPDigitStream FPDigitStream::LogBaseE()
+{
+    FPDigitStream stream(Kind_LogBaseE);
+    stream.seriesP = IntLimbs(1, 1);
+    stream.seriesQ = IntLimbs(1, 1);
+    stream.Extend(1);
+    return stream;
+}
+
+// 小数点以下count桁以上の数字を計算する
+void FPDigitStream::Extend(size_t count)
+{
+    if (count <= digits.length() || isExact) {
+        return;
+    }
+
+    // 少しずつ読み進める場合に計算の回数を抑えるため、それまでの桁数の2倍までまとめて計算する
+    size_t target = std::max(count, std::max(digits.length() * 2, kMinChunkDigits));
+    if (kind == Kind_Quotient) {
+        ExtendQuotient(target);
+    } else {
+        ExtendSeries(target);
+    }
+}
+
+// 商の小数点以下の数字をcount桁目まで計算する
+void FPDigitStream::ExtendQuotient(size_t count)
+{
+    // 余り * 10^k を割る数で割った商が、続くk桁の数字になる
+    size_t k = count - digits.length();
+    std::pair<IntLimbs, IntLimbs> div = IntLimbs_DivMod(IntLimbs_Mult(remain, PowerOfTen(k)), den);
+    std::string chunk = IntString_FromLimbs(div.first);
+    digits.append(k - chunk.length(), '0');
+    digits.append(chunk);
+    remain = div.second;
+    isExact = (remain.size() == 0);
+}
+
+// 定数の級数の項を増やして、小数点以下の数字をcount桁目まで計算する
+void FPDigitStream::ExtendSeries(size_t count)
+{
+    bool isPi = (kind == Kind_Pi);
+    IntLimbs scale = PowerOfTen(count);
+    uint32_t extraTerms = 0;
+    while (true) {
+        // 保存した積に、新しい項の範囲をbinary splittingでまとめたものをつなげる
+        uint32_t newCount = std::max(SeriesTermsForDigits(isPi, count), termCount) + extraTerms;
+        // 計算の途中でキャンセルされても保存した積と項の数が食い違わないように、すべての積を求めてから入れ替える
+        if (newCount > termCount) {
+            IntLimbs P, Q, T;
+            SplitSeries(isPi, termCount, newCount, P, Q, T);
+            IntLimbs newT = IntLimbs_Add(IntLimbs_Mult(seriesT, Q), IntLimbs_Mult(seriesP, T));
+            IntLimbs newP = IntLimbs_Mult(seriesP, P);
+            IntLimbs newQ = IntLimbs_Mult(seriesQ, Q);
+            seriesT.swap(newT);
+            seriesP.swap(newP);
+            seriesQ.swap(newQ);
+            termCount = newCount;
+        }
+
+        // 和は (Q + T) / Q で、残りの項の和は P / Q 未満（円周率はこれを2倍する）
+        IntLimbs lower = IntLimbs_Add(seriesQ, seriesT);
+        IntLimbs upper = IntLimbs_Add(lower, seriesP);
+        if (isPi) {
+            lower = IntLimbs_Add(lower, lower);
+            upper = IntLimbs_Add(upper, upper);
+        }
+
+        // 割り算が必要な桁数だけで済むように、分子と分母の下位のリムを切り捨てる。
+        // 切り捨てた分だけ下限は分母を1増やし、上限は分子を1増やして、範囲が真の値を含むようにする
+        size_t keepLimbs = count * 3322 / 32000 + 4;
+        size_t dropLimbs = (seriesQ.size() > keepLimbs)? (seriesQ.size() - keepLimbs): 0;
+        IntLimbs den = ShiftRightLimbs(seriesQ, dropLimbs);
+        lower = ShiftRightLimbs(lower, dropLimbs);
+        upper = ShiftRightLimbs(upper, dropLimbs);
+        IntLimbs lowerDen = den;
+        if (dropLimbs > 0) {
+            lowerDen = IntLimbs_Add(lowerDen, IntLimbs(1, 1));
+            upper = IntLimbs_Add(upper, IntLimbs(1, 1));
+        }
+        IntLimbs lowerDigits = IntLimbs_DivMod(IntLimbs_Mult(lower, scale), lowerDen).first;
+        IntLimbs upperDigits = IntLimbs_DivMod(IntLimbs_Mult(upper, scale), den).first;
+
+        // 範囲の両端で小数点以下count桁が一致すれば確定する。一致しなければ項を増やす
+        if (IntLimbs_Compare(lowerDigits, upperDigits) == 0) {
+            std::string str = IntString_FromLimbs(lowerDigits);
+            assert(str.length() > count);
+            std::string newIntPart = str.substr(0, str.length() - count);
+            std::string newDigits = str.substr(str.length() - count);
+            intPart.swap(newIntPart);
+            digits.swap(newDigits);
+            return;
+        }
+        extraTerms += termCount / 4 + 16;
+    }
+}
+
+// 小数点以下のindex+1桁目の数字を取得する
+int FPDigitStream::Digit(size_t index)
+{
+    Extend(index + 1);
+    return (index < digits.length())? (digits[index] - '0'): 0;
+}
+
+// 小数点以下の次の桁の数字を取得して、位置を1つ進める
+int FPDigitStream::Next()
+{
+    return Digit(position++);
+}
+
+// 小数点以下dp桁で切り捨てた値
+FPValue FPDigitStream::Truncate(int dp)
+{
+    assert(dp >= 0);
+    Extend(dp);
+    size_t length = std::min((size_t)dp, digits.length());
+    return FPValue(sign, intPart + digits.substr(0, length), (int)length);
+}
+
+// 小数点以下dp桁に丸めた値
+FPValue FPDigitStream::Round(int dp, RoundMode mode)
+{
+    assert(dp >= 0);
+    Extend(dp + 1);
+
+    // dp+1桁目までの数字に、その後ろに0以外の数字があるかどうかを表す1桁を加えれば、どの丸め方法でも正しく丸められる
+    size_t length = std::min((size_t)dp + 1, digits.length());
+    std::string vstr = intPart + digits.substr(0, length);
+    bool hasRest = !isExact || digits.find_first_not_of('0', length) != std::string::npos;
+    if (hasRest) {
+        vstr.append((size_t)dp + 1 - length, '0');
+        vstr.push_back('1');
+        length = dp + 2;
+    }
+    return FPValue(sign, vstr, (int)length).Round(dp, mode);
+}
@@ -0,0 +1,119 @@
+#ifndef FPDigitStream_hpp
+#define FPDigitStream_hpp
+
+#include "FPValue.hpp"
+#include "IntLimbsHelper.hpp"
+
+#include <cstdint>
+#include <string>
+
+
+/*!
+    数値の小数点以下の数字を、必要になった分だけ計算しながら順に取り出すためのストリームです。
+    割り算の商（Quotient）と、円周率（Pi）・自然対数の底（LogBaseE）のストリームを作成できます。
+    計算済みの数字と途中の状態（商では割り算の余り、定数では級数をbinary splittingでまとめた整数）を保持しておき、
+    先の桁が必要になったときは、その状態から計算を再開します。桁数を少しずつ増やしながら読み進めても、最初から計算し直すことはありません。
+    1回に計算する桁数は、それまでに計算した桁数の2倍まで広げます。
+    同じオブジェクトを複数のスレッドから同時に使うことはできません。
+ */
+class FPDigitStream
+{
+    /*! ストリームの種類 */
+    enum Kind {
+        Kind_Quotient,
+        Kind_Pi,
+        Kind_LogBaseE,
+    };
+
+    /*! ストリームの種類 */
+    Kind        kind;
+
+    /*! 符号を表す数値。1か-1（0の場合は1） */
+    int         sign;
+
+    /*! 整数部の数字（0の場合は"0"） */
+    std::string intPart;
+
+    /*! 計算済みの小数点以下の数字 */
+    std::string digits;
+
+    /*! digitsより後の数字がすべて0かどうか（割り切れた商の場合） */
+    bool        isExact;
+
+    /*! Next()で次に返す数字の位置 */
+    size_t      position;
+
+    /*! 商: 割り算の余り（digitsの最後の桁まで割った余り） */
+    IntLimbs    remain;
+
+    /*! 商: 割る数（商が整数部になるように10の累乗倍したもの） */
+    IntLimbs    den;
+
+    /*! 定数: 級数の第1項から第(termCount-1)項までの、項の比の分子の積 */
+    IntLimbs    seriesP;
+
+    /*! 定数: 級数の第1項から第(termCount-1)項までの、項の比の分母の積 */
+    IntLimbs    seriesQ;
+
+    /*! 定数: 級数の第1項から第(termCount-1)項までの和にseriesQを掛けたもの */
+    IntLimbs    seriesT;
+
+    /*! 定数: seriesP, seriesQ, seriesTに含めた項の数（第0項を含む） */
+    uint32_t    termCount;
+
+    /*! 種類を指定したコンストラクタ。 */
+    explicit FPDigitStream(Kind kind);
+
+    /*! 小数点以下count桁以上の数字を計算します（割り切れた商では、それより短い場合があります）。 */
+    void    Extend(size_t count);
+
+    /*! 商の小数点以下の数字をcount桁目まで計算します。 */
+    void    ExtendQuotient(size_t count);
+
+    /*! 定数の級数の項を増やして、小数点以下の数字をcount桁目まで計算します。 */
+    void    ExtendSeries(size_t count);
+
+public:
+    /*!
+        dividendをdivisorで割った商のストリームを作成します。divisorが0の場合は例外を投げます。
+        小数点以下の数字は、保存した余りから筆算を再開して計算します。
+     */
+    static FPDigitStream    Quotient(const FPValue& dividend, const FPValue& divisor);
+
+    /*! 円周率のストリームを作成します（π = 2 Σ k!/(3・5・…・(2k+1)) の級数を使います）。 */
+    static FPDigitStream    Pi();
+
+    /*! 自然対数の底eのストリームを作成します（e = Σ 1/k! の級数を使います）。 */
+    static FPDigitStream    LogBaseE();
+
+public:
+    /*! 符号を取得します（1か-1。0の場合は1）。 */
+    int                 Sign() const { return sign; }
+
+    /*! 整数部の数字を取得します。 */
+    const std::string&  IntegerPart() const { return intPart; }
+
+    /*! 小数点以下のindex+1桁目（indexは0から）の数字を取得します。まだ計算していない桁であれば、その桁まで計算します。 */
+    int                 Digit(size_t index);
+
+    /*! 小数点以下の次の桁の数字を取得して、位置を1つ進めます。最初の呼び出しでは小数点以下1桁目を返します。 */
+    int                 Next();
+
+    /*! Next()で次に返す数字の位置（小数点以下の何桁目の手前か）を取得します。 */
+    size_t              Position() const { return position; }
+
+    /*! これまでに計算した小数点以下の桁数を取得します。 */
+    size_t              ComputedDigits() const { return digits.length(); }
+
+    /*! 数値を小数点以下dp桁で切り捨てた（0に近づけた）値を取得します。 */
+    FPValue             Truncate(int dp);
+
+    /*!
+        数値を小数点以下dp桁に丸めた値を取得します（正しく丸めた値）。
+        @param mode     丸め方法（デフォルト値は通常の四捨五入を表すRoundMode_HalfUp）
+     */
+    FPValue             Round(int dp, RoundMode mode = RoundMode_HalfUp);
+
+};
+
+#endif /* FPDigitStream_hpp */
@@ -0,0 +1,189 @@
+#include "FPDiskLimbs.hpp"
+#include "FPComputeContext.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/*!
+    dst[0, ...)にsrcを足し込み、桁上がりを上位に伝播させます。dstは桁あふれしない大きさである必要があります。
+ */
+static void AddInto(uint32_t *dst, size_t dstCount, const IntLimbs& src)
+{
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < src.size(); i++) {
+        uint64_t t = (uint64_t)dst[i] + src[i] + carry;
+        dst[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    for (; carry > 0 && i < dstCount; i++) {
+        uint64_t t = (uint64_t)dst[i] + carry;
+        dst[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    if (carry > 0) {
+        throw std::runtime_error("Disk limb array overflow.");
+    }
+}
+
+
+// コンストラクタ
+FPDiskLimbs::FPDiskLimbs(const std::string& path)
+    : path(path), fd(-1), data(nullptr), count(0)
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + strerror(errno));
+    }
+    count = (size_t)st.st_size / sizeof(uint32_t);
+    Map();
+}
+
+// デストラクタ
+FPDiskLimbs::~FPDiskLimbs()
+{
+    Unmap();
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+// マップ
+void FPDiskLimbs::Map()
+{
+    if (count == 0) {
+        data = nullptr;
+        return;
+    }
+    void *mapped = mmap(nullptr, count * sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        data = nullptr;
+        throw std::runtime_error("Cannot map " + path + ": " + strerror(errno));
+    }
+    data = (uint32_t *)mapped;
+}
+
+// マップの解除
+void FPDiskLimbs::Unmap()
+{
+    if (data) {
+        munmap(data, count * sizeof(uint32_t));
+        data = nullptr;
+    }
+}
+
+// リム数の変更
+void FPDiskLimbs::Resize(size_t newCount)
+{
+    Unmap();
+    if (ftruncate(fd, (off_t)(newCount * sizeof(uint32_t))) < 0) {
+        throw std::runtime_error("Cannot resize " + path + ": " + strerror(errno));
+    }
+    count = newCount;
+    Map();
+}
+
+// 上位の不要な0を取り除く
+void FPDiskLimbs::Normalize()
+{
+    size_t n = count;
+    while (n > 0 && data[n-1] == 0) {
+        n--;
+    }
+    if (n != count) {
+        Resize(n);
+    }
+}
+
+// メモリ上のリム配列で置き換える
+void FPDiskLimbs::Assign(const IntLimbs& limbs)
+{
+    Resize(0);
+    Resize(limbs.size());
+    if (limbs.size() > 0) {
+        memcpy(data, limbs.data(), limbs.size() * sizeof(uint32_t));
+    }
+}
+
+// 範囲の読み込み
+IntLimbs FPDiskLimbs::Read(size_t begin, size_t len) const
+{
+    if (begin >= count) {
+        return IntLimbs();
+    }
+    size_t end = std::min(count, begin + len);
+    IntLimbs ret(data + begin, data + end);
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+// ディスクへの書き出し
+void FPDiskLimbs::Sync()
+{
+    if (data && msync(data, count * sizeof(uint32_t), MS_SYNC) < 0) {
+        throw std::runtime_error("Cannot sync " + path + ": " + strerror(errno));
+    }
+    fsync(fd);
+}
+
+// ブロックごとの掛け算
+void FPDiskLimbs::Mult(const FPDiskLimbs& a, const FPDiskLimbs& b, FPDiskLimbs& out, size_t blockLimbs)
+{
+    out.Resize(0);
+    out.Resize(a.Size() + b.Size());
+    for (size_t i = 0; i < a.Size(); i += blockLimbs) {
+        IntLimbs blockA = a.Read(i, blockLimbs);
+        if (blockA.size() == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < b.Size(); j += blockLimbs) {
+            FPComputeContext::CheckPoint();
+            IntLimbs product = IntLimbs_Mult(blockA, b.Read(j, blockLimbs));
+            AddInto(out.Data() + i + j, out.Size() - i - j, product);
+        }
+    }
+    out.Normalize();
+}
+
+// メモリ上の数との掛け算
+void FPDiskLimbs::Mult(const FPDiskLimbs& a, const IntLimbs& b, FPDiskLimbs& out, size_t blockLimbs)
+{
+    out.Resize(0);
+    out.Resize(a.Size() + b.size());
+    for (size_t i = 0; i < a.Size(); i += blockLimbs) {
+        FPComputeContext::CheckPoint();
+        IntLimbs product = IntLimbs_Mult(a.Read(i, blockLimbs), b);
+        AddInto(out.Data() + i, out.Size() - i, product);
+    }
+    out.Normalize();
+}
+
+// メモリ上の数との足し算
+void FPDiskLimbs::Add(const FPDiskLimbs& a, const IntLimbs& b, FPDiskLimbs& out)
+{
+    size_t n = std::max(a.Size(), b.size()) + 1;
+    if (&out != &a) {
+        out.Resize(0);
+        out.Resize(n);
+        if (a.Size() > 0) {
+            memcpy(out.Data(), a.Data(), a.Size() * sizeof(uint32_t));
+        }
+    } else {
+        out.Resize(n);
+    }
+    AddInto(out.Data(), out.Size(), b);
+    out.Normalize();
+}
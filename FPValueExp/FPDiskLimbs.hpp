@@ -0,0 +1,95 @@
+#ifndef FPDiskLimbs_hpp
+#define FPDiskLimbs_hpp
+
+#include "IntLimbsHelper.hpp"
+
+#include <cstdint>
+#include <string>
+
+
+/*!
+    メモリマップしたファイルに格納するリム配列です。
+    メモリに収まらない大きさの整数を扱うためのもので、ファイルの内容はリムを下位から順に並べたもの（リトルエンディアン）です。
+    リム数はファイルの大きさから決まるので、同じパスを開き直せば以前の内容をそのまま使うことができます。
+ */
+class FPDiskLimbs
+{
+    /*! ファイルのパス */
+    std::string path;
+
+    /*! ファイル記述子 */
+    int         fd;
+
+    /*! マップしたリム配列の先頭 */
+    uint32_t    *data;
+
+    /*! リム数 */
+    size_t      count;
+
+    /*! 現在のリム数でファイルをマップし直します。 */
+    void    Map();
+
+    /*! マップを解除します。 */
+    void    Unmap();
+
+public:
+    /*!
+        コンストラクタ。ファイルを開いてマップします。ファイルがなければ空のファイルを作成します。
+        ファイルを開けなかった場合は例外を投げます。
+     */
+    explicit FPDiskLimbs(const std::string& path);
+
+    /*! デストラクタ。マップを解除してファイルを閉じます（ファイルは削除しません）。 */
+    ~FPDiskLimbs();
+
+    FPDiskLimbs(const FPDiskLimbs&) = delete;
+    FPDiskLimbs& operator=(const FPDiskLimbs&) = delete;
+
+public:
+    /*!
+        リム配列aとbの積を、ブロックごとに計算してoutに格納します。
+        a・bをそれぞれblockLimbsリムずつ読み込んでメモリ上で掛け算し、outの対応する位置に足し込むので、
+        メモリに同時に置くのはブロック4つ分だけです。outはaやbと異なるファイルである必要があります。
+     */
+    static void Mult(const FPDiskLimbs& a, const FPDiskLimbs& b, FPDiskLimbs& out, size_t blockLimbs);
+
+    /*! ファイル上のリム配列aに、メモリ上のリム配列bを掛けた積をoutに格納します。 */
+    static void Mult(const FPDiskLimbs& a, const IntLimbs& b, FPDiskLimbs& out, size_t blockLimbs);
+
+    /*! ファイル上のリム配列aに、メモリ上のリム配列bを足した和をoutに格納します。outはaと同じファイルでも構いません。 */
+    static void Add(const FPDiskLimbs& a, const IntLimbs& b, FPDiskLimbs& out);
+
+public:
+    /*! ファイルのパスを取得します。 */
+    const std::string&  Path() const { return path; }
+
+    /*! リム数を取得します。 */
+    size_t      Size() const { return count; }
+
+    /*! リム配列の先頭を取得します。 */
+    uint32_t    *Data() { return data; }
+
+    /*! リム配列の先頭を取得します。 */
+    const uint32_t *Data() const { return data; }
+
+    /*! リム数を変更します。増やした部分は0になります。 */
+    void        Resize(size_t newCount);
+
+    /*! 上位の不要な0を取り除きます。 */
+    void        Normalize();
+
+    /*! メモリ上のリム配列の内容で置き換えます。 */
+    void        Assign(const IntLimbs& limbs);
+
+    /*! [begin, begin+len)の範囲のリムをメモリ上に読み込みます（正規化した配列を返します）。 */
+    IntLimbs    Read(size_t begin, size_t len) const;
+
+    /*! 全体をメモリ上に読み込みます。 */
+    IntLimbs    ReadAll() const { return Read(0, count); }
+
+    /*! 変更した内容をディスクに書き出します。 */
+    void        Sync();
+
+};
+
+#endif /* FPDiskLimbs_hpp */
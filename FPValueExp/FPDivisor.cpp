@@ -0,0 +1,74 @@
+#include "FPDivisor.hpp"
+#include "IntStringHelper.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+
+// コンストラクタ
+FPDivisor::FPDivisor(const FPValue& divisor, int maxDigits)
+    : divisor(divisor)
+{
+    if (divisor.IsZero()) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+    den = IntString_ToLimbs(IntString_Normalize(divisor.vstr));
+
+    // maxDigits桁の10進数が収まるリム数（10進1桁は約3.33ビット）。Barrett法にはdenのリム数の2倍以上が必要
+    size_t valueLimbs = (size_t)maxDigits * 3322 / 32000 + 1;
+    inverseLimbs = std::max(valueLimbs, den.size() * 2);
+    inverse = IntLimbs_Reciprocal(den, inverseLimbs);
+}
+
+// 割り算
+FPValue FPDivisor::Divide(const FPValue& dividend, int dp, RoundMode mode) const
+{
+    assert(dp >= 0);
+    if (dividend.IsZero()) {
+        return FPValue();
+    }
+
+    // (X / 10^xdp) / (den / 10^ddp) の商を小数点以下dp桁で求めるには、X * 10^(dp + ddp - xdp) を den で割る
+    // 10の累乗が負になる場合は、割られる数の下の桁を切り離して、余りの計算の時に戻す
+    int shift = dp + divisor.dp - dividend.dp;
+    std::string numStr = dividend.vstr;
+    std::string lowStr;
+    if (shift >= 0) {
+        numStr.append(shift, '0');
+    } else {
+        size_t cut = std::min((size_t)-shift, numStr.length());
+        lowStr = numStr.substr(numStr.length() - cut);
+        numStr.erase(numStr.length() - cut);
+        lowStr.insert(0, -shift - cut, '0');
+    }
+    IntLimbs num = IntString_ToLimbs(IntString_Normalize(numStr.empty()? "0": numStr));
+
+    // 事前計算した逆数を使って割り算する（大きすぎる数は通常の割り算で計算する）
+    std::pair<IntLimbs, IntLimbs> div = (num.size() <= inverseLimbs)?
+        IntLimbs_DivModReciprocal(num, den, inverse, inverseLimbs): IntLimbs_DivMod(num, den);
+    IntLimbs& quot = div.first;
+
+    // 余りと割る数（切り離した下の桁がある場合は、その分だけずらしたもの）
+    IntLimbs remain = div.second;
+    IntLimbs fullDen = den;
+    if (!lowStr.empty()) {
+        IntLimbs scale = IntString_ToLimbs("1" + std::string(lowStr.length(), '0'));
+        remain = IntLimbs_Add(IntLimbs_Mult(remain, scale), IntString_ToLimbs(IntString_Normalize(lowStr)));
+        fullDen = IntLimbs_Mult(den, scale);
+    }
+
+    // 商の丸め（商の絶対値を1単位大きくするかどうか）
+    int sign = dividend.sign * divisor.sign;
+    bool isRemainZero = (remain.size() == 0);
+    int halfCompare = isRemainZero? -1: IntLimbs_Compare(IntLimbs_Add(remain, remain), fullDen);
+    bool isOdd = (quot.size() > 0 && (quot[0] & 1) != 0);
+    if (FPValue::IsQuotientRoundUp(mode, sign, isRemainZero, halfCompare, isOdd)) {
+        quot = IntLimbs_Add(quot, IntLimbs(1, 1));
+    }
+    if (quot.size() == 0) {
+        return FPValue();
+    }
+    return FPValue(sign, IntString_FromLimbs(quot), dp);
+}
@@ -0,0 +1,50 @@
+#ifndef FPDivisor_hpp
+#define FPDivisor_hpp
+
+#include "FPValue.hpp"
+#include "IntLimbsHelper.hpp"
+
+
+/*!
+    同じ数値で何度も割り算を行うための、逆数を事前計算した割る数です。
+    コンストラクタで割る数を整数に正規化し、その逆数（Barrett法のための値）を1度だけ計算しておきます。
+    Divide()は、割られる数と逆数の掛け算・商と割る数の掛け算・高々2回の補正だけで商を求めます。
+    Divide()はこのオブジェクトを変更しないので、複数のスレッドから同時に呼び出すことができます。
+ */
+class FPDivisor
+{
+    /*! 割る数 */
+    FPValue     divisor;
+
+    /*! 割る数の数値文字列を整数として表したリム配列（割る数 = den / 10^divisor.dp） */
+    IntLimbs    den;
+
+    /*! 逆数 floor(B^inverseLimbs / den) */
+    IntLimbs    inverse;
+
+    /*! 逆数を計算したときのBの指数。これより長い数の割り算は、逆数を使わずに計算します */
+    size_t      inverseLimbs;
+
+public:
+    /*!
+        コンストラクタ。割る数の逆数を事前計算します。
+        @param divisor      割る数。0の場合は例外を投げます。
+        @param maxDigits    逆数を使って割り算できる数（割られる数を、商が整数になるように10の累乗倍したもの）の最大桁数
+     */
+    explicit FPDivisor(const FPValue& divisor, int maxDigits = 80);
+
+public:
+    /*! 割る数を取得します。 */
+    const FPValue&  Divisor() const { return divisor; }
+
+    /*!
+        dividendを割る数で割った商を、小数点以下dp桁に丸めて計算します。
+        @param dividend 割られる数
+        @param dp       商の小数点以下の桁数
+        @param mode     丸め方法（デフォルト値は通常の四捨五入を表すRoundMode_HalfUp）
+     */
+    FPValue Divide(const FPValue& dividend, int dp, RoundMode mode = RoundMode_HalfUp) const;
+
+};
+
+#endif /* FPDivisor_hpp */
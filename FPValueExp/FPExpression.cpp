@@ -0,0 +1,379 @@
+#include "FPExpression.hpp"
+#include "FPComputeContext.hpp"
+#include "FPMath.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <stdexcept>
+
+
+/*!
+    空白を読み飛ばします。
+ */
+static void SkipSpaces(const std::string& formula, size_t& pos)
+{
+    while (pos < formula.length() && isspace((unsigned char)formula[pos])) {
+        pos++;
+    }
+}
+
+/*!
+    数式の誤りを表す例外を投げます。
+ */
+static void ThrowSyntaxError(const std::string& formula, size_t pos)
+{
+    throw std::runtime_error("Syntax error at position " + std::to_string(pos) + " in formula \"" + formula + "\".");
+}
+
+/*!
+    指定した文字を読み飛ばします。その文字がなければ例外を投げます。
+ */
+static void Expect(const std::string& formula, size_t& pos, char c)
+{
+    SkipSpaces(formula, pos);
+    if (pos >= formula.length() || formula[pos] != c) {
+        ThrowSyntaxError(formula, pos);
+    }
+    pos++;
+}
+
+
+// コンストラクタ
+FPExpression::FPExpression(const std::string& formula, int dp)
+    : maxStackDepth(0), dp(dp)
+{
+    assert(dp >= 0);
+
+    size_t pos = 0;
+    ParseSum(formula, pos);
+    SkipSpaces(formula, pos);
+    if (pos < formula.length()) {
+        ThrowSyntaxError(formula, pos);
+    }
+
+    // 評価に必要なスタックの深さを求める
+    int depth = 0;
+    for (const Instruction& inst : code) {
+        depth += (inst.op == OpCode_PushConst || inst.op == OpCode_PushVar)? 1: (1 - OperandCount(inst.op));
+        maxStackDepth = std::max(maxStackDepth, depth);
+    }
+}
+
+// 和と差の解析
+void FPExpression::ParseSum(const std::string& formula, size_t& pos)
+{
+    ParseProduct(formula, pos);
+    while (true) {
+        SkipSpaces(formula, pos);
+        if (pos >= formula.length() || (formula[pos] != '+' && formula[pos] != '-')) {
+            break;
+        }
+        OpCode op = (formula[pos] == '+')? OpCode_Add: OpCode_Sub;
+        pos++;
+        ParseProduct(formula, pos);
+        EmitOperation(op);
+    }
+}
+
+// 積・商・剰余の解析
+void FPExpression::ParseProduct(const std::string& formula, size_t& pos)
+{
+    ParseUnary(formula, pos);
+    while (true) {
+        SkipSpaces(formula, pos);
+        if (pos >= formula.length() || (formula[pos] != '*' && formula[pos] != '/' && formula[pos] != '%')) {
+            break;
+        }
+        OpCode op = (formula[pos] == '*')? OpCode_Mult: (formula[pos] == '/')? OpCode_Div: OpCode_Mod;
+        pos++;
+        ParseUnary(formula, pos);
+        EmitOperation(op);
+    }
+}
+
+// 単項の + - の解析
+void FPExpression::ParseUnary(const std::string& formula, size_t& pos)
+{
+    SkipSpaces(formula, pos);
+    if (pos < formula.length() && formula[pos] == '-') {
+        pos++;
+        ParseUnary(formula, pos);
+        EmitOperation(OpCode_Negate);
+    } else if (pos < formula.length() && formula[pos] == '+') {
+        pos++;
+        ParseUnary(formula, pos);
+    } else {
+        ParsePower(formula, pos);
+    }
+}
+
+// 累乗の解析（-2^2 は -(2^2)、2^3^2 は 2^(3^2) とする）
+void FPExpression::ParsePower(const std::string& formula, size_t& pos)
+{
+    ParsePrimary(formula, pos);
+    SkipSpaces(formula, pos);
+    if (pos < formula.length() && formula[pos] == '^') {
+        pos++;
+        ParseUnary(formula, pos);
+        EmitOperation(OpCode_Pow);
+    }
+}
+
+// 数値・変数・関数の呼び出し・括弧の解析
+void FPExpression::ParsePrimary(const std::string& formula, size_t& pos)
+{
+    static const struct {
+        const char  *name;
+        OpCode      op;
+    } kFunctions[] = {
+        { "sin",    OpCode_Sin },
+        { "cos",    OpCode_Cos },
+        { "exp",    OpCode_Exp },
+        { "log",    OpCode_Log },
+        { "sqrt",   OpCode_Sqrt },
+        { "abs",    OpCode_Abs },
+    };
+
+    SkipSpaces(formula, pos);
+    if (pos >= formula.length()) {
+        ThrowSyntaxError(formula, pos);
+    }
+    char c = formula[pos];
+
+    // 括弧で囲まれた式
+    if (c == '(') {
+        pos++;
+        ParseSum(formula, pos);
+        Expect(formula, pos, ')');
+        return;
+    }
+
+    // 数値のリテラル
+    if (isdigit((unsigned char)c) || c == '.') {
+        size_t start = pos;
+        int digitCount = 0;
+        while (pos < formula.length() && isdigit((unsigned char)formula[pos])) {
+            pos++;
+            digitCount++;
+        }
+        if (pos < formula.length() && formula[pos] == '.') {
+            pos++;
+            while (pos < formula.length() && isdigit((unsigned char)formula[pos])) {
+                pos++;
+                digitCount++;
+            }
+        }
+        if (digitCount == 0) {
+            ThrowSyntaxError(formula, start);
+        }
+        if (pos < formula.length() && (formula[pos] == 'e' || formula[pos] == 'E')) {
+            // 指数部（"1.5e-3"）。数字が続かない場合は指数部とみなさない
+            size_t expPos = pos + 1;
+            if (expPos < formula.length() && (formula[expPos] == '+' || formula[expPos] == '-')) {
+                expPos++;
+            }
+            if (expPos < formula.length() && isdigit((unsigned char)formula[expPos])) {
+                pos = expPos;
+                while (pos < formula.length() && isdigit((unsigned char)formula[pos])) {
+                    pos++;
+                }
+            }
+        }
+        EmitConst(FPValue(formula.c_str() + start, pos - start));
+        return;
+    }
+
+    // 名前（関数・定数・変数）
+    if (!isalpha((unsigned char)c) && c != '_') {
+        ThrowSyntaxError(formula, pos);
+    }
+    size_t start = pos;
+    while (pos < formula.length() && (isalnum((unsigned char)formula[pos]) || formula[pos] == '_')) {
+        pos++;
+    }
+    std::string name = formula.substr(start, pos - start);
+    SkipSpaces(formula, pos);
+    if (pos < formula.length() && formula[pos] == '(') {
+        for (const auto& func : kFunctions) {
+            if (name == func.name) {
+                pos++;
+                ParseSum(formula, pos);
+                Expect(formula, pos, ')');
+                EmitOperation(func.op);
+                return;
+            }
+        }
+        throw std::runtime_error("Unknown function \"" + name + "\" in formula \"" + formula + "\".");
+    }
+    if (name == "pi") {
+        EmitConst(FPMath::Pi(dp));
+        return;
+    }
+    int index = VariableIndex(name);
+    if (index < 0) {
+        index = (int)variables.size();
+        variables.push_back(name);
+    }
+    Instruction inst = { OpCode_PushVar, index };
+    code.push_back(inst);
+}
+
+// 定数を積む命令の追加
+void FPExpression::EmitConst(const FPValue& value)
+{
+    Instruction inst = { OpCode_PushConst, (int)constants.size() };
+    constants.push_back(value);
+    code.push_back(inst);
+}
+
+// 演算の命令の追加
+void FPExpression::EmitOperation(OpCode op)
+{
+    // 直前のn個の命令がすべて定数ならば、それらがこの演算の引数になっている
+    int n = OperandCount(op);
+    bool isFoldable = ((int)code.size() >= n);
+    for (int i = 0; i < n && isFoldable; i++) {
+        isFoldable = (code[code.size() - 1 - i].op == OpCode_PushConst);
+    }
+    if (isFoldable) {
+        FPValue args[2];
+        for (int i = 0; i < n; i++) {
+            args[i] = constants[code[code.size() - n + i].index];
+        }
+        try {
+            Apply(op, args, dp);
+        } catch (FPComputeCancelled&) {
+            throw;
+        } catch (std::runtime_error&) {
+            // ゼロ除算などは評価時に例外を投げるように、畳み込まずに残しておく
+            isFoldable = false;
+        }
+        if (isFoldable) {
+            for (int i = 0; i < n; i++) {
+                code.pop_back();
+                constants.pop_back();
+            }
+            EmitConst(args[0]);
+            return;
+        }
+    }
+    Instruction inst = { op, 0 };
+    code.push_back(inst);
+}
+
+// 引数の個数
+int FPExpression::OperandCount(OpCode op)
+{
+    switch (op) {
+        case OpCode_PushConst:
+        case OpCode_PushVar:
+            return 0;
+        case OpCode_Add:
+        case OpCode_Sub:
+        case OpCode_Mult:
+        case OpCode_Div:
+        case OpCode_Mod:
+        case OpCode_Pow:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// 演算の計算
+void FPExpression::Apply(OpCode op, FPValue *args, int dp)
+{
+    switch (op) {
+        case OpCode_Add:
+            args[0] = FPValue::Add(args[0], args[1]);
+            break;
+        case OpCode_Sub:
+            args[0] = FPValue::Sub(args[0], args[1]);
+            break;
+        case OpCode_Mult:
+            args[0] = FPValue::Mult(args[0], args[1]);
+            break;
+        case OpCode_Div:
+            args[0] = FPValue::Div(args[0], args[1], dp, true);
+            break;
+        case OpCode_Mod:
+            args[0] = FPValue::DivMod(args[0], args[1]).second;
+            break;
+        case OpCode_Pow:
+            args[0] = FPMath::Pow(args[0], args[1], dp);
+            break;
+        case OpCode_Negate:
+            args[0] = args[0].Negate();
+            break;
+        case OpCode_Sin:
+            args[0] = FPMath::Sin(args[0], dp);
+            break;
+        case OpCode_Cos:
+            args[0] = FPMath::Cos(args[0], dp);
+            break;
+        case OpCode_Exp:
+            args[0] = FPMath::Exp(args[0], dp);
+            break;
+        case OpCode_Log:
+            args[0] = FPMath::Log(args[0], dp);
+            break;
+        case OpCode_Sqrt:
+            args[0] = FPMath::Sqrt(args[0], dp);
+            break;
+        case OpCode_Abs:
+            if (FPValue::Compare(args[0], FPValue()) < 0) {
+                args[0] = args[0].Negate();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// 変数の番号
+int FPExpression::VariableIndex(const std::string& name) const
+{
+    std::vector<std::string>::const_iterator it = std::find(variables.begin(), variables.end(), name);
+    return (it != variables.end())? (int)(it - variables.begin()): -1;
+}
+
+// 定数かどうかの判定
+bool FPExpression::IsConstant() const
+{
+    return (code.size() == 1 && code[0].op == OpCode_PushConst);
+}
+
+// 評価
+FPValue FPExpression::Evaluate(const std::vector<FPValue>& values, Scratch& scratch) const
+{
+    if (values.size() < variables.size()) {
+        throw std::runtime_error("Too few variable values for the formula.");
+    }
+
+    // スタックは作業領域のものを使い回し、代入で値を入れ替える
+    std::vector<FPValue>& stack = scratch.stack;
+    if ((int)stack.size() < maxStackDepth) {
+        stack.resize(maxStackDepth);
+    }
+    int sp = 0;
+    for (const Instruction& inst : code) {
+        if (inst.op == OpCode_PushConst) {
+            stack[sp++] = constants[inst.index];
+        } else if (inst.op == OpCode_PushVar) {
+            stack[sp++] = values[inst.index];
+        } else {
+            sp -= OperandCount(inst.op);
+            Apply(inst.op, &stack[sp], dp);
+            sp++;
+        }
+    }
+    return stack[0];
+}
+
+// 作業領域を作成して評価
+FPValue FPExpression::Evaluate(const std::vector<FPValue>& values) const
+{
+    Scratch scratch;
+    return Evaluate(values, scratch);
+}
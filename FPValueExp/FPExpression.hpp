@@ -0,0 +1,131 @@
+#ifndef FPExpression_hpp
+#define FPExpression_hpp
+
+#include "FPValue.hpp"
+
+#include <string>
+#include <vector>
+
+
+/*!
+    "(a * 1.075 - fee) / qty" のような数式の文字列を1回だけ解析してバイトコードにコンパイルし、
+    変数の値を変えながら繰り返し評価するためのクラスです。
+    演算子は + - * / % ^ と単項の + -、関数は sin cos exp log sqrt abs、定数は pi が使えます。
+    それ以外の名前は変数として扱い、最初に現れた順に0から番号を付けます。
+    変数を含まない部分式（リテラル同士の演算や、定数を引数にした関数の呼び出し）は、コンパイル時に計算して定数にまとめます。
+    割り算は小数点以下dp桁に四捨五入し、累乗・関数はFPMathの各関数で小数点以下dp桁まで計算します。
+ */
+class FPExpression
+{
+public:
+    /*!
+        評価に使う作業領域です。評価するスレッドごとに1つ作成して使い回すと、評価のたびにスタックを確保し直さずに済みます。
+     */
+    class Scratch
+    {
+        /*! 評価用のスタック */
+        std::vector<FPValue>    stack;
+
+        friend FPExpression;
+    };
+
+private:
+    /*! バイトコードの命令の種類 */
+    enum OpCode {
+        OpCode_PushConst,
+        OpCode_PushVar,
+        OpCode_Add,
+        OpCode_Sub,
+        OpCode_Mult,
+        OpCode_Div,
+        OpCode_Mod,
+        OpCode_Pow,
+        OpCode_Negate,
+        OpCode_Sin,
+        OpCode_Cos,
+        OpCode_Exp,
+        OpCode_Log,
+        OpCode_Sqrt,
+        OpCode_Abs,
+    };
+
+    /*! バイトコードの命令。indexはPushConstでは定数の番号、PushVarでは変数の番号です。 */
+    struct Instruction
+    {
+        OpCode  op;
+        int     index;
+    };
+
+    /*! バイトコード（逆ポーランド記法の順に並んだ命令） */
+    std::vector<Instruction>    code;
+
+    /*! 定数の一覧 */
+    std::vector<FPValue>        constants;
+
+    /*! 変数名の一覧 */
+    std::vector<std::string>    variables;
+
+    /*! 評価に必要なスタックの深さ */
+    int                         maxStackDepth;
+
+    /*! 割り算・累乗・関数の小数点以下の桁数 */
+    int                         dp;
+
+    /*! 和と差（最も優先順位の低い式）を解析します。 */
+    void    ParseSum(const std::string& formula, size_t& pos);
+
+    /*! 積・商・剰余を解析します。 */
+    void    ParseProduct(const std::string& formula, size_t& pos);
+
+    /*! 単項の + - を解析します。 */
+    void    ParseUnary(const std::string& formula, size_t& pos);
+
+    /*! 累乗（右結合）を解析します。 */
+    void    ParsePower(const std::string& formula, size_t& pos);
+
+    /*! 数値・変数・関数の呼び出し・括弧で囲まれた式を解析します。 */
+    void    ParsePrimary(const std::string& formula, size_t& pos);
+
+    /*! 定数を積む命令を追加します。 */
+    void    EmitConst(const FPValue& value);
+
+    /*! 演算の命令を追加します。引数がすべて直前に積まれた定数であれば、その場で計算して定数に置き換えます。 */
+    void    EmitOperation(OpCode op);
+
+    /*! 演算opの引数の個数を取得します。 */
+    static int  OperandCount(OpCode op);
+
+    /*! 演算opを計算し、結果をargs[0]に格納します。args[0]〜args[引数の個数-1]に引数を入れておく必要があります。 */
+    static void Apply(OpCode op, FPValue *args, int dp);
+
+public:
+    /*!
+        コンストラクタ。数式をコンパイルします。数式に誤りがある場合は例外を投げます。
+        @param formula  数式の文字列
+        @param dp       割り算・累乗・関数を計算する小数点以下の桁数
+     */
+    FPExpression(const std::string& formula, int dp);
+
+public:
+    /*! 変数名の一覧を、変数の番号の順に取得します。 */
+    const std::vector<std::string>& Variables() const { return variables; }
+
+    /*! 変数名から変数の番号を取得します。数式に含まれない名前の場合は-1をリターンします。 */
+    int     VariableIndex(const std::string& name) const;
+
+    /*! 数式が変数を含まず、コンパイル時に1つの定数にまとめられたかどうかを判定します。 */
+    bool    IsConstant() const;
+
+    /*!
+        変数に値を割り当てて数式を評価します。数式の解析は行いません。
+        @param values   変数の番号の順に並べた値（Variables()と同じ個数以上が必要です）
+        @param scratch  評価に使う作業領域
+     */
+    FPValue Evaluate(const std::vector<FPValue>& values, Scratch& scratch) const;
+
+    /*! 変数に値を割り当てて数式を評価します。作業領域は呼び出しのたびに作成します。 */
+    FPValue Evaluate(const std::vector<FPValue>& values) const;
+
+};
+
+#endif /* FPExpression_hpp */
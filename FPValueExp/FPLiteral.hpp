@@ -0,0 +1,191 @@
+#ifndef FPLiteral_hpp
+#define FPLiteral_hpp
+
+#include "FPValue.hpp"
+
+#include <string>
+#include <type_traits>
+
+
+/*!
+    コンパイル時に解析された数値リテラルの情報です。
+    整数部・小数部の数字の範囲は、不要なゼロを取り除いた状態で保持します。
+ */
+struct FPLiteralInfo
+{
+    /*! 正しい形式のリテラルかどうか */
+    bool    isValid;
+
+    /*! 符号を表す数値。1か-1 */
+    int     sign;
+
+    /*! 整数部の数字の範囲（先頭の不要な0を除いたもの） */
+    int     intBegin;
+    int     intEnd;
+
+    /*! 小数部の数字の範囲（末尾の不要な0を除いたもの） */
+    int     decBegin;
+    int     decEnd;
+
+    /*! 指数部の値（"1.5e-300"の-300。指数部がなければ0） */
+    int     exponent;
+};
+
+/*!
+    "3.14159", "+3.14", "-2.6352", "1.5e-300"といった数値の文字列を、コンパイル時に解析します。
+    数値リテラルの桁区切り（'）は数字の一部として読み飛ばします。
+ */
+constexpr FPLiteralInfo FPLiteral_Parse(const char *str, int len)
+{
+    FPLiteralInfo info = { false, 1, 0, 0, 0, 0, 0 };
+    int pos = 0;
+
+    // 符号
+    if (pos < len && (str[pos] == '+' || str[pos] == '-')) {
+        info.sign = (str[pos] == '+')? 1: -1;
+        pos++;
+    }
+
+    // 整数部
+    info.intBegin = pos;
+    int digitCount = 0;
+    while (pos < len && ((str[pos] >= '0' && str[pos] <= '9') || str[pos] == '\'')) {
+        digitCount += (str[pos] != '\'')? 1: 0;
+        pos++;
+    }
+    info.intEnd = pos;
+
+    // 小数部
+    info.decBegin = pos;
+    info.decEnd = pos;
+    if (pos < len && str[pos] == '.') {
+        pos++;
+        info.decBegin = pos;
+        while (pos < len && ((str[pos] >= '0' && str[pos] <= '9') || str[pos] == '\'')) {
+            digitCount += (str[pos] != '\'')? 1: 0;
+            pos++;
+        }
+        info.decEnd = pos;
+    }
+
+    // 指数部
+    if (digitCount > 0 && pos < len && (str[pos] == 'e' || str[pos] == 'E')) {
+        pos++;
+        int expSign = 1;
+        if (pos < len && (str[pos] == '+' || str[pos] == '-')) {
+            expSign = (str[pos] == '+')? 1: -1;
+            pos++;
+        }
+        int expBegin = pos;
+        while (pos < len && str[pos] >= '0' && str[pos] <= '9') {
+            info.exponent = info.exponent * 10 + (str[pos] - '0');
+            if (info.exponent > 100000000) {
+                return info;
+            }
+            pos++;
+        }
+        if (pos == expBegin) {
+            return info;
+        }
+        info.exponent *= expSign;
+    }
+
+    // 数字が1つもない場合と、解析できない文字が残っている場合はエラー
+    if (digitCount == 0 || pos != len) {
+        return info;
+    }
+
+    // 前後の不要な0を取り除く
+    while (info.intBegin < info.intEnd && (str[info.intBegin] == '0' || str[info.intBegin] == '\'')) {
+        info.intBegin++;
+    }
+    while (info.decBegin < info.decEnd && (str[info.decEnd-1] == '0' || str[info.decEnd-1] == '\'')) {
+        info.decEnd--;
+    }
+
+    // マイナスの0は許容しない
+    if (info.intBegin == info.intEnd && info.decBegin == info.decEnd) {
+        info.sign = 1;
+    }
+
+    info.isValid = true;
+    return info;
+}
+
+/*!
+    コンパイル時に解析したリテラルの情報から、FPValueを作成します。
+ */
+inline FPValue FPLiteral_MakeValue(const char *str, const FPLiteralInfo& info)
+{
+    std::string vstr;
+    for (int i = info.intBegin; i < info.intEnd; i++) {
+        if (str[i] != '\'') {
+            vstr += str[i];
+        }
+    }
+    int dp = 0;
+    for (int i = info.decBegin; i < info.decEnd; i++) {
+        if (str[i] != '\'') {
+            vstr += str[i];
+            dp++;
+        }
+    }
+    if (vstr.length() == 0) {
+        vstr = "0";
+    }
+    return FPValue(info.sign, vstr, dp - info.exponent);
+}
+
+/*!
+    リテラルの文字をテンプレート引数から文字列として取り出すためのクラスです。
+ */
+template <char... Cs>
+struct FPLiteralChars
+{
+    static constexpr char str[sizeof...(Cs) + 1] = { Cs..., '\0' };
+};
+
+template <char... Cs>
+constexpr char FPLiteralChars<Cs...>::str[sizeof...(Cs) + 1];
+
+/*!
+    FPValueの数値リテラル（例: 3.14159_fp）。
+    リテラルの解析はコンパイル時に行われ、形式が正しくない場合はコンパイルエラーになります。
+    作成した数値はリテラルごとに1度だけ構築され、以降はそのコピーを返します。
+    FPValueはc_str()で内部のバッファを書き換えるので、複数のスレッドで共有するインスタンスそのものは返しません。
+ */
+template <char... Cs>
+FPValue operator"" _fp()
+{
+    constexpr FPLiteralInfo info = FPLiteral_Parse(FPLiteralChars<Cs...>::str, (int)sizeof...(Cs));
+    static_assert(info.isValid, "Malformed FPValue literal.");
+    static const FPValue value = FPLiteral_MakeValue(FPLiteralChars<Cs...>::str, info);
+    return value;
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#if defined(__clang__)
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+
+/*!
+    FPValueの文字列リテラル（例: "-2.6352"_fp）。符号を含めることができます。
+    GNU拡張の文字列リテラル演算子テンプレートを使い、解析はコンパイル時に行われます。
+    形式が正しくない場合はコンパイルエラーになり、作成した数値はリテラルごとに1度だけ構築されて、そのコピーを返します。
+ */
+template <typename CharT, CharT... Cs>
+FPValue operator"" _fp()
+{
+    static_assert(std::is_same<CharT, char>::value, "FPValue literal must be a narrow string.");
+    constexpr FPLiteralInfo info = FPLiteral_Parse(FPLiteralChars<Cs...>::str, (int)sizeof...(Cs));
+    static_assert(info.isValid, "Malformed FPValue literal.");
+    static const FPValue value = FPLiteral_MakeValue(FPLiteralChars<Cs...>::str, info);
+    return value;
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+#endif /* FPLiteral_hpp */
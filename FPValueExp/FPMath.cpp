@@ -1,171 +1,770 @@
 #include "FPMath.hpp"
+#include "FPAccumulator.hpp"
+#include "FPComputeContext.hpp"
+#include "FPDigitStream.hpp"
 #include "IntStringHelper.hpp"
+#include "FPLiteral.hpp"
+#include "FPTrace.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <climits>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+/*! 近似値の計算で、求める桁数に加えて内部で余分に計算する桁数 */
+static const int kApproxGuardDigits = 10;
+
+/*! 正しく丸めた結果を求める際に、最初に余分に計算する桁数 */
+static const int kZivGuardDigits = 3;
+
+/*! 正しく丸めた結果を求める際に、精度を上げる上限（2*dp + この桁数を超えたら、その時点の値を丸めて返す） */
+static const int kZivMaxExtraDigits = 64;
+
+/*! 近似値の誤差の上限（近似値の最後の桁の単位で、これ未満の誤差を保証する） */
+static const int kApproxErrorUlps = 2;
+
+/*! FPMath::Powで整数乗を掛け算で正確に計算する結果の桁数の上限（それより大きい場合は指数関数と対数で計算する） */
+static const double kMaxExactPowDigits = 1000000;
+
+/*! FPMath::Piが表から返せる円周率の最大桁数（それより多い桁はFPDigitStreamで計算する） */
+static const int kMaxPiDigits = 1000;
+
+/*! 倍精度浮動小数点数の計算で結果を求めることを試す、小数点以下の桁数の上限 */
+static const int kHardwareMaxDP = 15;
+
+/*! 倍精度浮動小数点数の丸めの単位（2^-53） */
+static const double kUnitRoundoff = 1.0 / 9007199254740992.0;
+
+/*! 数学ライブラリの関数（sin, cos, exp, log, pow）の誤差の上限として見込む、結果の相対誤差（4ulp） */
+static const double kLibmRelativeError = 8 * kUnitRoundoff;
+
+/*! 非正規化数の範囲の誤差を覆うために、誤差の上限に加える絶対誤差 */
+static const double kTinyAbsoluteError = 1e-300;
+
+/*! サイン・コサインを倍精度で計算する引数の絶対値の上限 */
+static const double kHardwareMaxAngle = 1e5;
+
+/*! 指数関数を倍精度で計算する引数（累乗の場合は exponent * log(base)）の絶対値の上限 */
+static const double kHardwareMaxExpArg = 700;
+
+
+/*!
+    数値を倍精度浮動小数点数に変換します。ゼロか、正規化数の範囲に収まる（相対誤差が丸めの単位以下になる）場合だけtrueをリターンします。
+ */
+static bool ToNormalDouble(const FPValue& value, double& d)
+{
+    d = value.ToDouble();
+    return value.IsZero() || (std::isfinite(d) && std::fabs(d) >= DBL_MIN);
+}
+
+/*!
+    10^dp倍した値vを整数に丸めます。|v| < 2^52であれば、小数部の取り出しを含めて誤差なく計算できます。
+    RoundMode_HalfUp（0から遠い方への四捨五入）とRoundMode_Truncateのみに対応し、どちらもvについて単調です。
+ */
+static double RoundScaledDouble(double v, RoundMode mode)
+{
+    double a = std::fabs(v);
+    double n = std::floor(a);
+    if (mode == RoundMode_HalfUp && a - n >= 0.5) {
+        n += 1;
+    }
+    return (v < 0)? -n: n;
+}
+
+/*!
+    倍精度で計算した近似値yと、真の値との誤差の上限errから、真の値を小数点以下dp桁に丸めた値が確定するか調べます。
+    (y - err) × 10^dpと(y + err) × 10^dpを同じ整数に丸められれば、その値をresultに格納してtrueをリターンします。
+    @param mode     RoundMode_HalfUpかRoundMode_Truncate
+ */
+static bool RoundIfDetermined(double y, double err, int dp, RoundMode mode, FPValue& result)
+{
+    assert(dp >= 0 && dp <= 22);
+    if (!std::isfinite(y) || !std::isfinite(err)) {
+        return false;
+    }
+
+    // 10^dpは誤差なく表せる。範囲の両端を10^dp倍する計算の丸め誤差（それぞれ1ulp程度）の分だけ、範囲を広げておく
+    double scale = 1;
+    for (int i = 0; i < dp; i++) {
+        scale *= 10;
+    }
+    double margin = err + 4 * kUnitRoundoff * (std::fabs(y) + err);
+    double lo = (y - margin) * scale;
+    double hi = (y + margin) * scale;
+    if (!(std::fabs(lo) < 4503599627370496.0 && std::fabs(hi) < 4503599627370496.0)) {
+        return false;
+    }
+    double n = RoundScaledDouble(lo, mode);
+    if (n != RoundScaledDouble(hi, mode)) {
+        return false;
+    }
+    result = FPValue((n < 0)? -1: 1, std::to_string((long long)std::fabs(n)), dp);
+    return true;
+}
+
+/*! 引数を倍精度に変換した誤差の上限（|x|の相対誤差は丸めの単位以下） */
+static double ArgumentError(double x)
+{
+    return std::fabs(x) * kUnitRoundoff * 1.01;
+}
+
+/*!
+    倍精度のサインと誤差の上限を計算します（|sin'| <= 1 なので、引数の誤差はそのまま結果の誤差になります）。
+ */
+static bool SinKernel(double x, double& y, double& err)
+{
+    if (std::fabs(x) > kHardwareMaxAngle) {
+        return false;
+    }
+    y = std::sin(x);
+    err = ArgumentError(x) + std::fabs(y) * kLibmRelativeError + kTinyAbsoluteError;
+    return true;
+}
+
+/*!
+    倍精度のコサインと誤差の上限を計算します。
+ */
+static bool CosKernel(double x, double& y, double& err)
+{
+    if (std::fabs(x) > kHardwareMaxAngle) {
+        return false;
+    }
+    y = std::cos(x);
+    err = ArgumentError(x) + std::fabs(y) * kLibmRelativeError + kTinyAbsoluteError;
+    return true;
+}
+
+/*!
+    倍精度の指数関数と誤差の上限を計算します（引数の誤差dxに対して、結果の相対誤差は約dxになります）。
+ */
+static bool ExpKernel(double x, double& y, double& err)
+{
+    if (x < -kHardwareMaxExpArg) {
+        // 結果は10^-304より小さいので、0を近似値とする
+        y = 0;
+        err = kTinyAbsoluteError;
+        return true;
+    }
+    if (x > kHardwareMaxExpArg) {
+        return false;
+    }
+    y = std::exp(x);
+    err = std::fabs(y) * (ArgumentError(x) * 1.01 + kLibmRelativeError) + kTinyAbsoluteError;
+    return true;
+}
+
+/*!
+    倍精度の自然対数と誤差の上限を計算します（引数の相対誤差は、そのまま結果の絶対誤差になります）。
+ */
+static bool LogKernel(double x, double& y, double& err)
+{
+    if (x <= 0) {
+        return false;
+    }
+    y = std::log(x);
+    err = kUnitRoundoff * 1.02 + std::fabs(y) * kLibmRelativeError + kTinyAbsoluteError;
+    return true;
+}
 
 
 // 自然対数の底
 FPValue FPMath::LogBaseE(int dp)
 {
-    std::string last_vstr("");
-    int sameCount = 0;
-    FPValue ret("0");
-    std::string base = "0";
-    for (int i = 0; i < INT_MAX; i++) {
-        std::string fact = IntString_Fact(base);
-        ret += FPValue::Div(FPValue("1"), fact, dp, true);
-        if (i >= 10 && ret.dp == dp) {
-            if (last_vstr == ret.vstr) {
-                sameCount++;
-                if (sameCount > 3) {
-                    break;
-                }
-            }
-            last_vstr = ret.vstr;
-        }
-        base = IntString_Add(base, "1");
-    }
-    return ret;
+    FPTrace::Scope trace(FPTraceOp_LogBaseE, dp, 0);
+
+    // 前回までに計算した桁から続けて計算する
+    static std::mutex streamMutex;
+    static FPDigitStream stream = FPDigitStream::LogBaseE();
+    std::lock_guard<std::mutex> lock(streamMutex);
+    return stream.Round(dp, RoundMode_HalfUp);
 }
 
 // 円周率
 FPValue FPMath::Pi(int dp)
 {
-    assert(dp >= 0 && dp <= 1000);
+    FPTrace::Scope trace(FPTraceOp_Pi, dp, 0);
+    assert(dp >= 0);
 
-    static const std::string piStr = "31415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679821480865132823066470938446095505822317253594081284811174502841027019385211055596446229489549303819644288109756659334461284756482337867831652712019091456485669234603486104543266482133936072602491412737245870066063155881748815209209628292540917153643678925903600113305305488204665213841469519415116094330572703657595919530921861173819326117931051185480744623799627495673518857527248912279381830119491298336733624406566430860213949463952247371907021798609437027705392171762931767523846748184676694051320005681271452635608277857713427577896091736371787214684409012249534301465495853710507922796892589235420199561121290219608640344181598136297747713099605187072113499999983729780499510597317328160963185950244594553469083026425223082533446850352619311881710100031378387528865875332083814206171776691473035982534904287554687311595628638823537875937519577818577805321712268066130019278766111959092164201989";
+    static const char piStr[] = "31415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679821480865132823066470938446095505822317253594081284811174502841027019385211055596446229489549303819644288109756659334461284756482337867831652712019091456485669234603486104543266482133936072602491412737245870066063155881748815209209628292540917153643678925903600113305305488204665213841469519415116094330572703657595919530921861173819326117931051185480744623799627495673518857527248912279381830119491298336733624406566430860213949463952247371907021798609437027705392171762931767523846748184676694051320005681271452635608277857713427577896091736371787214684409012249534301465495853710507922796892589235420199561121290219608640344181598136297747713099605187072113499999983729780499510597317328160963185950244594553469083026425223082533446850352619311881710100031378387528865875332083814206171776691473035982534904287554687311595628638823537875937519577818577805321712268066130019278766111959092164201989";
+
+    if (dp <= kMaxPiDigits) {
+        return FPValue(1, std::string(piStr, dp+1), dp);
+    }
 
-    return FPValue(1, piStr.substr(0, dp+1), dp);
+    // 表にない桁は、前回までに計算した桁から続けて計算する
+    static std::mutex streamMutex;
+    static FPDigitStream stream = FPDigitStream::Pi();
+    std::lock_guard<std::mutex> lock(streamMutex);
+    return stream.Truncate(dp);
 }
 
 // サインを計算する
 FPValue FPMath::Sin(const FPValue& angle, int dp)
 {
-    std::string last_vstr("");
-    int sameCount = 0;
-    int last_dp = 0;
-    int dpSameCount = 0;
-    FPValue ret("0");
-    std::string base("1");
-    int sign = 1;
-    for (int i = 0; i < INT_MAX; i++) {
-        std::string fact = IntString_Fact(base);
-        FPValue num = Pow(angle, base, 20);
-        FPValue p = FPValue::Div(num, fact, dp, true);
-        ret = (sign > 0)? (ret + p): (ret - p);
-        if (i >= 10 && ret.dp == dp) {
-            if (last_vstr == ret.vstr) {
-                sameCount++;
-                if (sameCount > 3) {
-                    break;
-                }
+    FPTrace::Scope trace(FPTraceOp_Sin, dp, 0, &angle);
+    return SinBatch(std::vector<FPValue>(1, angle), dp)[0];
+}
+
+// コサインを計算する
+FPValue FPMath::Cos(const FPValue& angle, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_Cos, dp, 0, &angle);
+    return CosBatch(std::vector<FPValue>(1, angle), dp)[0];
+}
+
+// baseのexponent乗
+FPValue FPMath::Pow(const FPValue& base, const FPValue& exponent, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_Pow, dp, 0, &base, &exponent);
+
+    // ゼロ乗は1と定義する
+    if (exponent.IsZero()) {
+        return "1"_fp;
+    }
+
+    if (exponent.dp <= 0) {
+        // 整数乗で結果の桁数が大きすぎない場合は、2乗を繰り返す掛け算で正確に計算する
+        int expLen = (int)exponent.vstr.length() - exponent.dp;
+        if (expLen <= 9) {
+            int n = std::atoi(exponent.IntegerPart().c_str());
+            double baseDigits = std::max((double)base.vstr.length(), std::fabs((double)DecimalExponent(base)) + 1);
+            if (baseDigits * n <= kMaxExactPowDigits) {
+                FPValue pow = PowInt(base, n, -1);
+                return (exponent.sign > 0)? pow: FPValue::Div("1"_fp, pow, dp, true);
             }
-            last_vstr = ret.vstr;
         }
-        if (i >= 10) {
-            if (last_dp == ret.dp) {
-                dpSameCount++;
-                if (dpSameCount > 10) {
-                    break;
-                }
+
+        // 大きな整数乗は小数乗と同じく計算し、負の数の奇数乗は符号を反転させる。
+        // ただし、結果の整数部が正確に計算する桁数の上限を超える場合は例外を投げる
+        if (!base.IsZero()) {
+            int be = DecimalExponent(base);
+            double log10Base = std::log10(std::fabs(std::atof(TruncateDP(Scale10(base, -be), 17).c_str()))) + be;
+            if (std::atof(exponent.c_str()) * log10Base > kMaxExactPowDigits) {
+                throw std::runtime_error("Exponent is too large.");
             }
-            last_dp = ret.dp;
         }
-        sign *= -1;
-        base = IntString_Add(base, "2");
+        if (base.sign < 0 && !base.IsZero()) {
+            bool isOdd = (exponent.dp == 0 && (exponent.vstr.back() - '0') % 2 == 1);
+            FPValue pow = Pow(base.Negate(), exponent, dp);
+            return isOdd? pow.Negate(): pow;
+        }
     }
-    return ret;
+
+    // 小数乗（と大きな整数乗）の場合は base^exponent = e^(exponent * log(base)) を計算する
+    if (base.IsZero()) {
+        if (exponent.sign < 0) {
+            throw std::runtime_error("Zero division is now allowed.");
+        }
+        return FPValue();
+    }
+    if (base.sign < 0) {
+        throw std::runtime_error("Fractional power of a negative number is not allowed.");
+    }
+
+    // 精度が低い場合は、まず倍精度で計算してみる（結果の相対誤差は、log(y)の誤差 |e| * db/b + |log b| * de と、powの誤差の和）
+    double b = 0, e = 0;
+    if (dp <= kHardwareMaxDP && ToNormalDouble(base, b) && ToNormalDouble(exponent, e) && std::fabs(e * std::log(b)) <= kHardwareMaxExpArg) {
+        double y = std::pow(b, e);
+        double logErr = (std::fabs(e) + std::fabs(e * std::log(b))) * kUnitRoundoff * 1.01;
+        double err = std::fabs(y) * (logErr * 1.01 + kLibmRelativeError) + kTinyAbsoluteError;
+        FPValue result;
+        if (RoundIfDetermined(y, err, dp, RoundMode_HalfUp, result)) {
+            return result;
+        }
+    }
+    return ZivRound(std::vector<FPValue>(1, base), dp, [&](const std::vector<FPValue>& args, int wp) {
+        return std::vector<FPValue>(1, PowApprox(args[0], exponent, wp));
+    })[0];
 }
 
-// コサインを計算する
-FPValue FPMath::Cos(const FPValue& angle, int dp)
+// 平方根
+FPValue FPMath::Sqrt(const FPValue& value, int dp)
 {
-    std::string last_vstr("");
-    int sameCount = 0;
-    int last_dp = 0;
-    int dpSameCount = 0;
-    FPValue ret("0");
-    std::string base("0");
-    int sign = 1;
-    for (int i = 0; i < INT_MAX; i++) {
-        std::string fact = IntString_Fact(base);
-        FPValue num = Pow(angle, base, 20);
-        FPValue p = FPValue::Div(num, fact, dp, true);
-        ret = (sign > 0)? (ret + p): (ret - p);
-        if (i >= 10 && ret.dp == dp) {
-            if (last_vstr == ret.vstr) {
-                sameCount++;
-                if (sameCount > 3) {
-                    break;
-                }
+    FPTrace::Scope trace(FPTraceOp_Sqrt, dp, 0, &value);
+    return Root(value, 2, dp);
+}
+
+// n乗根
+FPValue FPMath::Root(const FPValue& value, int n, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_Root, dp, n, &value);
+    assert(dp >= 0);
+
+    if (n < 1) {
+        throw std::runtime_error("Root degree must be a positive integer.");
+    }
+    if (n == 1 || value.IsZero()) {
+        return TruncateDP(value, dp);
+    }
+
+    // 負の数は奇数乗根のみ計算できる
+    if (value.sign < 0) {
+        if (n % 2 == 0) {
+            throw std::runtime_error("Even root of a negative number is not allowed.");
+        }
+        return Root(value.Negate(), n, dp).Negate();
+    }
+
+    // 精度が低い平方根は、まず倍精度で計算してみる（sqrtは正しく丸めるので、誤差は引数の変換の分と合わせて2ulp以下）
+    double x = 0;
+    if (n == 2 && dp <= kHardwareMaxDP && ToNormalDouble(value, x)) {
+        double y = std::sqrt(x);
+        FPValue result;
+        if (RoundIfDetermined(y, y * 2 * kUnitRoundoff + kTinyAbsoluteError, dp, RoundMode_Truncate, result)) {
+            return result;
+        }
+    }
+
+    // value = m × 10^(n*k), 1 <= m < 10^n となるように桁をずらす
+    int e = DecimalExponent(value);
+    int k = (e >= 0)? (e / n): -((-e + n - 1) / n);
+    FPValue m = Scale10(value, -n * k);
+
+    // 必要な精度（m^(1/n)の小数点以下の桁数）と、精度を倍々に上げていく際の各段階の精度
+    const int guard = 5;
+    int targetDP = std::max(dp + k, 0) + guard;
+    std::vector<int> precs;
+    for (int p = targetDP; p > 14; p = p / 2 + 1) {
+        precs.push_back(p);
+    }
+    std::reverse(precs.begin(), precs.end());
+
+    // 倍精度の計算でy = m^(-1/n)の初期値を求める（nが大きいとmは倍精度の範囲を超えるので、常用対数で計算する）。
+    // y^nは10^-me程度まで小さくなるので、y^nを含む計算はme桁だけ精度を上げる
+    int me = DecimalExponent(m);
+    double log10M = std::log10(std::atof(TruncateDP(Scale10(m, -me), 17).c_str())) + me;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17f", std::pow(10.0, -log10M / n));
+    FPValue y = TruncateDP(FPValue(buf), 14);
+
+    // 逆数n乗根のニュートン法: y <- y + y * (1 - m * y^n) / n
+    const FPValue one = "1"_fp;
+    FPValue invN = (n == 2)? "0.5"_fp: FPValue::Div(one, FPValue(std::to_string(n)), targetDP + n + 4, false);
+    for (size_t i = 0; i < precs.size(); i++) {
+        FPComputeContext::CheckPoint();
+        FPComputeContext::ReportProgress(i, std::min(precs[i] / 2, dp));
+        int p = precs[i] + 4;
+        FPValue mp = TruncateDP(m, p);
+        FPValue err = one - TruncateDP(mp * PowInt(y, n, p + me), p);
+        y = TruncateDP(y + TruncateDP(y * err, p) * TruncateDP(invN, p), p);
+    }
+
+    // m^(1/n) = m * y^(n-1) を計算して桁を戻す
+    FPValue r = TruncateDP(m * PowInt(y, n - 1, targetDP + 4 + me), targetDP + 4);
+    r = TruncateDP(Scale10(r, k), dp);
+
+    // 最後の桁を補正して、r^n <= value < (r+ulp)^n を保証する
+    FPValue ulp(1, "1", dp);
+    while (FPValue::Compare(PowInt(r + ulp, n, -1), value) <= 0) {
+        r += ulp;
+    }
+    while (FPValue::Compare(PowInt(r, n, -1), value) > 0) {
+        r -= ulp;
+    }
+    return r;
+}
+
+// 自然対数
+FPValue FPMath::Log(const FPValue& value, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_Log, dp, 0, &value);
+    assert(dp >= 0);
+    if (value.IsZero() || value.sign < 0) {
+        throw std::runtime_error("Logarithm of a non-positive number is not allowed.");
+    }
+    return ZivRound(std::vector<FPValue>(1, value), dp, [](const std::vector<FPValue>& args, int wp) {
+        return std::vector<FPValue>(1, LogApprox(args[0], wp));
+    }, LogKernel)[0];
+}
+
+// 指数関数
+FPValue FPMath::Exp(const FPValue& x, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_Exp, dp, 0, &x);
+    return ExpBatch(std::vector<FPValue>(1, x), dp)[0];
+}
+
+// サインの一括計算
+std::vector<FPValue> FPMath::SinBatch(const std::vector<FPValue>& angles, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_SinBatch, dp, angles);
+    return ZivRound(angles, dp, [](const std::vector<FPValue>& args, int wp) {
+        return SinCosApprox(args, false, wp);
+    }, SinKernel);
+}
+
+// コサインの一括計算
+std::vector<FPValue> FPMath::CosBatch(const std::vector<FPValue>& angles, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_CosBatch, dp, angles);
+    return ZivRound(angles, dp, [](const std::vector<FPValue>& args, int wp) {
+        return SinCosApprox(args, true, wp);
+    }, CosKernel);
+}
+
+// 指数関数の一括計算
+std::vector<FPValue> FPMath::ExpBatch(const std::vector<FPValue>& values, int dp)
+{
+    FPTrace::Scope trace(FPTraceOp_ExpBatch, dp, values);
+    return ZivRound(values, dp, ExpApprox, ExpKernel);
+}
+
+// 正しく丸められるまで精度を上げながら計算する
+std::vector<FPValue> FPMath::ZivRound(const std::vector<FPValue>& args, int dp, const ApproxFunc& approx, HardwareKernel kernel)
+{
+    assert(dp >= 0);
+    std::vector<FPValue> ret(args.size());
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < args.size(); i++) {
+        // 精度が低い場合は、まず倍精度で計算してみる
+        double x = 0, y = 0, err = 0;
+        if (kernel && dp <= kHardwareMaxDP && ToNormalDouble(args[i], x) && kernel(x, y, err) && RoundIfDetermined(y, err, dp, RoundMode_HalfUp, ret[i])) {
+            continue;
+        }
+        pending.push_back(i);
+    }
+
+    int wp = dp + kZivGuardDigits;
+    for (int round = 1; pending.size() > 0; round++) {
+        std::vector<FPValue> subArgs;
+        for (size_t i = 0; i < pending.size(); i++) {
+            subArgs.push_back(args[pending[i]]);
+        }
+        std::vector<FPValue> values = approx(subArgs, wp);
+
+        // 誤差の範囲の両端が同じ値に丸められれば、その値が正しく丸めた結果になる
+        bool isLast = (wp >= 2 * dp + kZivMaxExtraDigits);
+        FPValue err(1, std::to_string(kApproxErrorUlps), wp);
+        std::vector<size_t> next;
+        for (size_t i = 0; i < pending.size(); i++) {
+            FPValue lower = (values[i] - err).Round(dp, RoundMode_HalfUp);
+            FPValue upper = (values[i] + err).Round(dp, RoundMode_HalfUp);
+            if (FPValue::Compare(lower, upper) == 0) {
+                ret[pending[i]] = lower;
+            } else if (isLast) {
+                // いくら精度を上げても決まらない場合は、ちょうど中間の値とみなして0から遠い方に丸める
+                ret[pending[i]] = (FPValue::AbsCompare(lower, upper) > 0)? lower: upper;
+            } else {
+                next.push_back(pending[i]);
             }
-            last_vstr = ret.vstr;
         }
-        if (i >= 10) {
-            if (last_dp == ret.dp) {
-                dpSameCount++;
-                if (dpSameCount > 10) {
-                    break;
-                }
+        pending.swap(next);
+        FPComputeContext::ReportProgress(round, pending.empty()? dp: std::min(dp, wp - kZivGuardDigits));
+        wp += std::max(kZivGuardDigits, wp / 2);
+    }
+    return ret;
+}
+
+// サイン・コサインの近似値
+std::vector<FPValue> FPMath::SinCosApprox(const std::vector<FPValue>& angles, bool isCos, int dp)
+{
+    if (angles.size() == 0) {
+        return std::vector<FPValue>();
+    }
+
+    // 引数の絶対値の最大値（倍精度の概算。倍精度の範囲を超える場合は無限大）と、その整数部の桁数
+    double maxAbs = 0.0;
+    int maxExponent = 0;
+    for (size_t i = 0; i < angles.size(); i++) {
+        maxAbs = std::max(maxAbs, std::fabs(std::atof(TruncateDP(angles[i], 17).c_str())));
+        if (!angles[i].IsZero()) {
+            maxExponent = std::max(maxExponent, DecimalExponent(angles[i]));
+        }
+    }
+
+    // 2πで縮約する。縮約に使う2πの誤差は、引く回数の桁数だけ余分に必要になる
+    int wp = dp + kApproxGuardDigits;
+    int turnDigits = maxExponent + 2;
+    bool isReduced = (maxAbs > M_PI);
+    FPValue twoPi;
+    FPValue invTwoPi;
+    if (isReduced) {
+        twoPi = Pi(wp + turnDigits) * "2"_fp;
+        invTwoPi = FPValue::Div("1"_fp, twoPi, turnDigits + 2, false);
+        maxAbs = M_PI + 1.0;
+    } else {
+        // 縮約しない場合は、途中の項の大きさ（最大でe^|x|程度）の分だけ桁落ちするので精度を上げる
+        wp += (int)std::ceil(maxAbs / std::log(10.0));
+    }
+
+    // 係数表の作成（全ての引数で共有）。x^kを掛けると係数の誤差も最大でmaxAbs^k倍になるので、その桁数だけ精度を上げる
+    int termCount = SeriesTermCount(maxAbs, wp) + 2;
+    int tableDP = wp + 2 + (int)std::ceil(termCount * std::log10(std::max(maxAbs, 1.0)));
+    std::vector<FPValue> invFact = InverseFactorials(termCount, tableDP);
+
+    // 各引数の計算を並列に行う
+    std::vector<FPValue> ret(angles.size());
+    ParallelFor(angles.size(), [&](size_t i) {
+        FPValue x = angles[i];
+        if (isReduced) {
+            FPValue turns = (x * invTwoPi).Round(0, RoundMode_HalfUp);
+            if (!turns.IsZero()) {
+                x = TruncateDP(x - turns * twoPi, wp + 2);
             }
-            last_dp = ret.dp;
         }
-        sign *= -1;
-        base = IntString_Add(base, "2");
+        ret[i] = TruncateDP(SinCosSeries(x, isCos, invFact, wp), dp);
+    });
+    return ret;
+}
+
+// 指数関数の近似値
+std::vector<FPValue> FPMath::ExpApprox(const std::vector<FPValue>& values, int dp)
+{
+    if (values.size() == 0) {
+        return std::vector<FPValue>();
+    }
+
+    // x = n + r に分けたときの整数部nの最大値
+    std::vector<int> ns(values.size());
+    int maxN = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        FPValue n = values[i].Round(0, RoundMode_HalfUp);
+        if (DecimalExponent(n) >= 9) {
+            throw std::runtime_error("Exponent is too large.");
+        }
+        ns[i] = n.sign * std::atoi(n.IntegerPart().c_str());
+        maxN = std::max(maxN, std::abs(ns[i]));
+    }
+
+    // e^nの整数部の桁数と、e^nを求める掛け算の回数の分だけ精度を上げる
+    int intDigits = (int)std::ceil(maxN / std::log(10.0)) + 1;
+    int wp = dp + kApproxGuardDigits + (int)std::ceil(std::log10(maxN + 1.0));
+    int p = wp + intDigits;
+
+    // 係数表とeの計算（全ての引数で共有）
+    std::vector<FPValue> invFact = InverseFactorials(SeriesTermCount(1.0, p) + 2, p + 2);
+    FPAccumulator eSum;
+    for (size_t k = 0; k < invFact.size(); k++) {
+        eSum.Add(invFact[k]);
     }
+    FPValue e = TruncateDP(eSum.Result(), p);
+
+    // 各引数の計算を並列に行う
+    std::vector<FPValue> ret(values.size());
+    ParallelFor(values.size(), [&](size_t i) {
+        int n = ns[i];
+        FPValue r = values[i] - FPValue(std::to_string(n));
+
+        // e^r = Σ r^k/k!
+        FPAccumulator sum;
+        FPValue pow = "1"_fp;
+        for (size_t k = 0; k < invFact.size(); k++) {
+            FPComputeContext::CheckPoint();
+            FPValue term = TruncateDP(pow * invFact[k], p);
+            if (k > 0 && term.IsZero()) {
+                break;
+            }
+            sum.Add(term);
+            pow = TruncateDP(pow * r, p);
+        }
+        FPValue result = sum.Result();
+
+        // e^n を掛ける
+        if (n != 0) {
+            FPValue en = PowInt(e, std::abs(n), p);
+            if (n < 0) {
+                en = FPValue::DivMod("1"_fp, en, p).first;
+            }
+            result = TruncateDP(result * en, p);
+        }
+        ret[i] = TruncateDP(result, dp);
+    });
     return ret;
 }
 
-// baseのexponent乗
-FPValue FPMath::Pow(const FPValue& base, const FPValue& exponent, int dp)
+// 自然対数の近似値
+FPValue FPMath::LogApprox(const FPValue& value, int dp)
 {
-    //printf("Pow (base=%s, exp=%s)\n", base.c_str(), exponent.c_str());
+    // 倍精度の計算で初期値を求める（value = m × 10^e）
+    int e = DecimalExponent(value);
+    double md = std::atof(TruncateDP(Scale10(value, -e), 17).c_str());
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17f", std::log(md) + e * std::log(10.0));
+    FPValue y = TruncateDP(FPValue(buf), 14);
 
-    // ゼロ乗は1と定義する
-    if (exponent.IsZero()) {
-        return FPValue("1");
+    // 精度を倍々に上げていく際の各段階の精度
+    int targetDP = dp + kApproxGuardDigits;
+    std::vector<int> precs;
+    for (int p = targetDP; p > 14; p = p / 2 + 1) {
+        precs.push_back(p);
+    }
+    std::reverse(precs.begin(), precs.end());
+    precs.push_back(targetDP);
+
+    // ニュートン法: y <- y + value * e^(-y) - 1（value * e^(-y)が1に近いので、e^(-y)はvalueの桁数だけ余分に計算する）
+    for (size_t i = 0; i < precs.size(); i++) {
+        FPComputeContext::CheckPoint();
+        int p = precs[i] + 4;
+        FPValue ey = ExpApprox(std::vector<FPValue>(1, y.Negate()), p + std::max(e + 1, 0))[0];
+        y = TruncateDP(y + TruncateDP(value * ey, p) - "1"_fp, p);
     }
+    return TruncateDP(y, dp);
+}
 
-    FPValue absexp = (exponent.sign > 0)? exponent: -exponent;
+// 小数乗の近似値
+FPValue FPMath::PowApprox(const FPValue& base, const FPValue& exponent, int dp)
+{
+    // 結果の整数部の桁数と指数の桁数の分だけ、log(base)と指数部を余分に計算する
+    int be = DecimalExponent(base);
+    double bm = std::atof(TruncateDP(Scale10(base, -be), 17).c_str());
+    double log10Base = std::log10(bm) + be;
+    double log10Result = (log10Base == 0)? 0: std::atof(TruncateDP(exponent, 17).c_str()) * log10Base;
 
-    // 整数乗の場合は普通に掛け算を計算する
-    if (exponent.dp == 0) {
-        FPValue pow("1");
-        FPValue exp(absexp);
-        while (!exp.IsZero()) {
-            pow = pow * base;
-            exp = exp - FPValue("1");
+    // 指数関数が計算できる範囲（引数の整数部が9桁未満）を超える場合は、精度を上げる前に例外を投げる。
+    // 結果が小数点以下dp桁よりも十分小さい場合は0を返す
+    if (!(log10Result < 4.0e8)) {
+        throw std::runtime_error("Exponent is too large.");
+    }
+    if (log10Result < -(double)dp - 10) {
+        return FPValue();
+    }
+    int intDigits = (log10Result > 0)? ((int)std::ceil(log10Result) + 1): 1;
+    int expDigits = std::max(0, DecimalExponent(exponent) + 1);
+    FPValue logBase = LogApprox(base, dp + intDigits + expDigits + 4);
+    FPValue t = TruncateDP(exponent * logBase, dp + intDigits + 4);
+    return ExpApprox(std::vector<FPValue>(1, t), dp)[0];
+}
+
+// 係数1/k!の表
+std::vector<FPValue> FPMath::InverseFactorials(int count, int dp)
+{
+    std::vector<FPValue> ret;
+    ret.reserve(count);
+    FPValue v = "1"_fp;
+    for (int k = 0; k < count; k++) {
+        FPComputeContext::CheckPoint();
+        if (k > 1) {
+            v = FPValue::DivMod(v, FPValue(std::to_string(k)), dp).first;
         }
-        return (exponent.sign > 0)? pow: (FPValue("1") / pow);
+        ret.push_back(v);
     }
+    return ret;
+}
 
-    // 小数乗の場合はマクローリン展開を計算する
-    int dimCount = 0;
-    FPValue pow("1");
-    FPValue x = base - FPValue("1");
-    FPValue alpha(absexp);
-    FPValue dalpha("1");
-    //printf("dimCount=%d, pow=%s\n", dimCount, pow.c_str());
+// 級数の項数の見積もり
+int FPMath::SeriesTermCount(double maxAbs, int dp)
+{
+    // log10(maxAbs^k / k!) < -dp となる最小のk
+    double logX = std::log10(std::max(maxAbs, 1e-300));
+    int k = 1;
+    while (k * logX - std::lgamma(k + 1.0) / std::log(10.0) > -dp - 1) {
+        k++;
+    }
+    return k;
+}
 
-    while (dimCount < dp - 1) {
-        FPValue fact("1");
-        FPValue ffact("2");
-        for (int i = 0; i < dimCount; i++) {
-            fact = fact * ffact;
-            ffact = ffact + FPValue("1");
+// サイン・コサインのテイラー級数
+FPValue FPMath::SinCosSeries(const FPValue& x, bool isCos, const std::vector<FPValue>& invFact, int dp)
+{
+    // sin x = Σ (-1)^k x^(2k+1)/(2k+1)!, cos x = Σ (-1)^k x^(2k)/(2k)!
+    FPValue x2 = TruncateDP(x * x, dp + 2);
+    FPValue pow = isCos? "1"_fp: x;
+    FPAccumulator sum;
+    for (size_t k = isCos? 0: 1; k < invFact.size(); k += 2) {
+        FPComputeContext::CheckPoint();
+        FPValue term = TruncateDP(pow * invFact[k], dp + 2);
+        if (k > 1 && term.IsZero()) {
+            break;
         }
-        FPValue p(x);
-        for (int i = 0; i < dimCount; i++) {
-            p = p * x;
+        if ((k / 2) % 2 == 0) {
+            sum.Add(term);
+        } else {
+            sum.Sub(term);
         }
-        //printf("  fact=%s, p=%s, alhpha=%s\n", fact.c_str(), p.c_str(), alpha.c_str());
-        pow = pow + (alpha * p / fact);
-        dimCount++;
-        //printf("dimCount=%d, pow=%s\n", dimCount, pow.c_str());
-        alpha = alpha * (absexp - dalpha);
-        dalpha = dalpha + FPValue("1");
+        pow = TruncateDP(pow * x2, dp + 2);
     }
+    return sum.Result();
+}
+
+// 並列実行
+void FPMath::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::atomic<size_t> next(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    FPComputeContext *context = FPComputeContext::Current();
+    bool isInsideTrace = FPTrace::IsInsideOperation();
+
+    // 次のインデックスを取り出しながら処理する（記録中の演算の内部の計算は、各スレッドでも記録しない）
+    auto worker = [&]() {
+        FPComputeContext::Scope scope(context);
+        FPTrace::Suppressor suppressor(isInsideTrace);
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// 小数点以下dp桁より下の切り捨て
+FPValue FPMath::TruncateDP(const FPValue& value, int dp)
+{
+    return value.Round(dp, RoundMode_Truncate);
+}
 
-    return (exponent.sign > 0)? pow: (FPValue("1") / pow);
+// 10のk乗倍
+FPValue FPMath::Scale10(const FPValue& value, int k)
+{
+    return FPValue(value.sign, value.vstr, value.dp - k);
 }
 
+// 10進指数
+int FPMath::DecimalExponent(const FPValue& value)
+{
+    return (int)value.vstr.length() - value.dp - 1;
+}
+
+// 正の整数乗
+FPValue FPMath::PowInt(const FPValue& base, int n, int truncDP)
+{
+    assert(n >= 1);
+    FPValue ret = "1"_fp;
+    FPValue b(base);
+    bool isFirst = true;
+    while (n > 0) {
+        FPComputeContext::CheckPoint();
+        if (n & 1) {
+            ret = isFirst? b: (ret * b);
+            isFirst = false;
+            if (truncDP >= 0) {
+                ret = TruncateDP(ret, truncDP);
+            }
+        }
+        n >>= 1;
+        if (n > 0) {
+            b = b * b;
+            if (truncDP >= 0) {
+                b = TruncateDP(b, truncDP);
+            }
+        }
+    }
+    return ret;
+}
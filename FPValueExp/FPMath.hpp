@@ -3,24 +3,128 @@
 
 #include "FPValue.hpp"
 
+#include <functional>
+#include <vector>
+
 
 struct FPMath
 {
-    /*! 自然対数の底eを求めます。 */
+    /*!
+        自然対数の底eを小数点以下dp桁まで求めます（正しく四捨五入した値）。
+        共有のFPDigitStreamから取り出すので、前回より多くの桁を求めるときは、増えた桁の分だけを計算します。
+     */
     static FPValue  LogBaseE(int dp);
 
-    /*! 円周率を小数点以下dp桁まで求めます。 */
+    /*!
+        円周率を小数点以下dp桁まで求めます（切り捨てた値）。dpに上限はありません。
+        1000桁までは表から返し、それより多い桁は共有のFPDigitStreamで、前回までに計算した桁の続きから計算します。
+     */
     static FPValue  Pi(int dp);
 
-    /*! サインを計算します。 */
+    /*! サインを小数点以下dp桁まで求めます（正しく四捨五入した値）。 */
     static FPValue  Sin(const FPValue& angle, int dp);
 
-    /*! コサインを計算します。 */
+    /*! コサインを小数点以下dp桁まで求めます（正しく四捨五入した値）。 */
     static FPValue  Cos(const FPValue& angle, int dp);
 
-    /*! 数値baseをexponent乗した数値を計算します。 */
+    /*!
+        数値baseをexponent乗した数値を計算します。
+        exponentが正の整数の場合は誤差のない値を、負の整数の場合は小数点以下dp桁で四捨五入した値を返します。
+        小数乗の場合は e^(exponent * log(base)) として計算し、小数点以下dp桁に正しく四捨五入した値を返します（baseは0以上である必要があります）。
+        整数乗でも、誤差のない値の桁数が100万桁を超える場合は小数乗と同じく計算します（結果の整数部が100万桁を超える場合は例外を投げます）。
+     */
     static FPValue  Pow(const FPValue& base, const FPValue& exponent, int dp);
 
+    /*!
+        平方根を小数点以下dp桁まで求めます（dp桁より下は切り捨て）。
+        逆数平方根のニュートン法を、倍精度の近似値から始めて精度を倍々に上げながら計算します。
+     */
+    static FPValue  Sqrt(const FPValue& value, int dp);
+
+    /*!
+        n乗根を小数点以下dp桁まで求めます（dp桁より下は切り捨て）。
+        負の数の場合、nが奇数であれば負のn乗根を計算し、nが偶数であれば例外を投げます。
+     */
+    static FPValue  Root(const FPValue& value, int n, int dp);
+
+    /*! 自然対数を小数点以下dp桁まで求めます（正しく四捨五入した値）。0以下の数値の場合は例外を投げます。 */
+    static FPValue  Log(const FPValue& value, int dp);
+
+    /*! 指数関数e^xを小数点以下dp桁まで求めます（正しく四捨五入した値）。 */
+    static FPValue  Exp(const FPValue& x, int dp);
+
+    /*!
+        複数の角度のサインをまとめて計算します（結果は小数点以下dp桁に正しく四捨五入した値）。
+        係数1/k!の表と、2πによる引数の縮約に使う円周率は1度だけ計算して全ての引数で共有し、各引数の計算は複数のスレッドで並列に行います。
+     */
+    static std::vector<FPValue> SinBatch(const std::vector<FPValue>& angles, int dp);
+
+    /*! 複数の角度のコサインをまとめて計算します。計算方法はSinBatch()と同じです。 */
+    static std::vector<FPValue> CosBatch(const std::vector<FPValue>& angles, int dp);
+
+    /*!
+        複数の数値の指数関数をまとめて計算します（結果は小数点以下dp桁に正しく四捨五入した値）。
+        x = n + r（nは整数、|r| <= 1/2）に分け、e^rは共有する係数表から、e^nは1度だけ求めたeの累乗から計算します。
+     */
+    static std::vector<FPValue> ExpBatch(const std::vector<FPValue>& values, int dp);
+
+private:
+    /*! 引数の配列と精度wpから、小数点以下wp桁の近似値の配列を計算する関数 */
+    typedef std::function<std::vector<FPValue>(const std::vector<FPValue>& args, int wp)> ApproxFunc;
+
+    /*!
+        倍精度浮動小数点数の引数xから、関数の近似値yと、元の引数（倍精度に変換する前の値）に対する真の値との誤差の上限errを計算する関数。
+        倍精度で計算できない引数の範囲であればfalseを返します。
+     */
+    typedef bool (*HardwareKernel)(double x, double& y, double& err);
+
+    /*!
+        各引数について、小数点以下dp桁に正しく四捨五入した値を求めます（Zivの方法）。
+        dpが小さい場合は、まずkernelで倍精度の近似値を求め、誤差の範囲の両端が同じ値に丸められればその値を使います。
+        それ以外の引数は、dpより少しだけ多い桁数で近似値を求め、誤差の範囲の両端が同じ値に丸められない引数についてだけ、精度を上げて計算し直します。
+        approxは、真の値との誤差が最後の桁の2単位未満の近似値を返す必要があります。
+     */
+    static std::vector<FPValue> ZivRound(const std::vector<FPValue>& args, int dp, const ApproxFunc& approx, HardwareKernel kernel = nullptr);
+
+    /*! サイン（isCos=falseのとき）またはコサイン（isCos=trueのとき）の、小数点以下dp桁の近似値を計算します。 */
+    static std::vector<FPValue> SinCosApprox(const std::vector<FPValue>& angles, bool isCos, int dp);
+
+    /*! 指数関数の、小数点以下dp桁の近似値を計算します。 */
+    static std::vector<FPValue> ExpApprox(const std::vector<FPValue>& values, int dp);
+
+    /*! 正の数の自然対数の、小数点以下dp桁の近似値をニュートン法で計算します。 */
+    static FPValue  LogApprox(const FPValue& value, int dp);
+
+    /*! 正の数baseの小数乗の、小数点以下dp桁の近似値を計算します。 */
+    static FPValue  PowApprox(const FPValue& base, const FPValue& exponent, int dp);
+
+    /*! 係数1/k!（k = 0〜count-1）を、小数点以下dp桁（それより下は切り捨て）で求めます。 */
+    static std::vector<FPValue> InverseFactorials(int count, int dp);
+
+    /*! |x| <= maxAbsのとき、x^k/k! が10^-dpより小さくなるまでに必要な項数を見積もります。 */
+    static int      SeriesTermCount(double maxAbs, int dp);
+
+    /*! sin（isCos=falseのとき）またはcos（isCos=trueのとき）のテイラー級数を、共有する係数表を使って計算します。 */
+    static FPValue  SinCosSeries(const FPValue& x, bool isCos, const std::vector<FPValue>& invFact, int dp);
+
+    /*!
+        0〜count-1の各インデックスについてfuncを呼び出します。呼び出しは複数のスレッドに分けて並列に行い、
+        呼び出し元のスレッドのFPComputeContextを各スレッドに引き継ぎます。funcが例外を投げた場合は、最初の例外を投げ直します。
+     */
+    static void     ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    /*! 小数点以下dp桁より下を切り捨てた数値を作成します。 */
+    static FPValue  TruncateDP(const FPValue& value, int dp);
+
+    /*! 数値を10のk乗倍した数値を作成します。kは負の数でも構いません。 */
+    static FPValue  Scale10(const FPValue& value, int k);
+
+    /*! 0でない数値の10進指数（value = d.ddd × 10^e となるe）を求めます。 */
+    static int      DecimalExponent(const FPValue& value);
+
+    /*! 数値baseの正の整数n乗を計算します。truncDPが0以上ならば、途中結果を小数点以下truncDP桁に切り捨てます。 */
+    static FPValue  PowInt(const FPValue& base, int n, int truncDP);
+
 };
 
 #endif /* FPMath_hpp */
@@ -0,0 +1,146 @@
+#include "FPMathAsync.hpp"
+#include "FPMath.hpp"
+
+#include <exception>
+#include <mutex>
+#include <thread>
+
+
+/*! デフォルトのエグゼキュータ */
+static std::mutex sExecutorMutex;
+static FPExecutor sDefaultExecutor;
+
+
+/*!
+    計算ごとに新しいスレッドを作って実行するエグゼキュータです。
+ */
+static void RunOnNewThread(std::function<void()> task)
+{
+    std::thread(std::move(task)).detach();
+}
+
+
+// コンストラクタ
+FPAsyncResult::FPAsyncResult(const std::shared_ptr<State>& _state)
+    : state(_state)
+{}
+
+// キャンセルの要求
+void FPAsyncResult::Cancel()
+{
+    state->context.Cancel();
+}
+
+// 計算が終わっているかどうか
+bool FPAsyncResult::IsReady() const
+{
+    return state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// 計算が終わるまで待つ
+void FPAsyncResult::Wait() const
+{
+    state->future.wait();
+}
+
+// 計算が終わるまで最大timeoutだけ待つ
+bool FPAsyncResult::WaitFor(std::chrono::steady_clock::duration timeout) const
+{
+    return state->future.wait_for(timeout) == std::future_status::ready;
+}
+
+// 計算結果の取得
+FPValue FPAsyncResult::Get() const
+{
+    return state->future.get();
+}
+
+// 進み具合の取得
+FPProgress FPAsyncResult::Progress() const
+{
+    return state->context.Progress();
+}
+
+
+// デフォルトのエグゼキュータの設定
+void FPMathAsync::SetDefaultExecutor(FPExecutor executor)
+{
+    std::lock_guard<std::mutex> lock(sExecutorMutex);
+    sDefaultExecutor = executor;
+}
+
+// 任意の計算を非同期に実行する
+FPAsyncResult FPMathAsync::Run(std::function<FPValue()> task, int targetDigits, const FPAsyncOptions& options)
+{
+    std::shared_ptr<FPAsyncResult::State> state = std::make_shared<FPAsyncResult::State>();
+    state->future = state->promise.get_future().share();
+    state->context.SetTargetDigits(targetDigits);
+    if (options.hasDeadline) {
+        state->context.SetDeadline(options.deadline);
+    }
+
+    // エグゼキュータの決定
+    FPExecutor executor = options.executor;
+    if (!executor) {
+        std::lock_guard<std::mutex> lock(sExecutorMutex);
+        executor = sDefaultExecutor;
+    }
+    if (!executor) {
+        executor = RunOnNewThread;
+    }
+
+    // 実行中のスレッドにコンテキストを関連付けて計算する。
+    // 例外（キャンセルを含む）で終わった場合は、途中の数値はスタックの巻き戻しで解放され、例外だけが結果に残る。
+    executor([state, task]() {
+        try {
+            FPComputeContext::Scope scope(&state->context);
+            FPComputeContext::CheckPoint();
+            state->promise.set_value(task());
+        } catch (...) {
+            state->promise.set_exception(std::current_exception());
+        }
+    });
+    return FPAsyncResult(state);
+}
+
+// 自然対数の底
+FPAsyncResult FPMathAsync::LogBaseE(int dp, const FPAsyncOptions& options)
+{
+    return Run([dp]() { return FPMath::LogBaseE(dp); }, dp, options);
+}
+
+// 円周率
+FPAsyncResult FPMathAsync::Pi(int dp, const FPAsyncOptions& options)
+{
+    return Run([dp]() { return FPMath::Pi(dp); }, dp, options);
+}
+
+// サイン
+FPAsyncResult FPMathAsync::Sin(const FPValue& angle, int dp, const FPAsyncOptions& options)
+{
+    return Run([angle, dp]() { return FPMath::Sin(angle, dp); }, dp, options);
+}
+
+// コサイン
+FPAsyncResult FPMathAsync::Cos(const FPValue& angle, int dp, const FPAsyncOptions& options)
+{
+    return Run([angle, dp]() { return FPMath::Cos(angle, dp); }, dp, options);
+}
+
+// 累乗
+FPAsyncResult FPMathAsync::Pow(const FPValue& base, const FPValue& exponent, int dp, const FPAsyncOptions& options)
+{
+    return Run([base, exponent, dp]() { return FPMath::Pow(base, exponent, dp); }, dp, options);
+}
+
+// 平方根
+FPAsyncResult FPMathAsync::Sqrt(const FPValue& value, int dp, const FPAsyncOptions& options)
+{
+    return Run([value, dp]() { return FPMath::Sqrt(value, dp); }, dp, options);
+}
+
+// n乗根
+FPAsyncResult FPMathAsync::Root(const FPValue& value, int n, int dp, const FPAsyncOptions& options)
+{
+    return Run([value, n, dp]() { return FPMath::Root(value, n, dp); }, dp, options);
+}
@@ -0,0 +1,127 @@
+#ifndef FPMathAsync_hpp
+#define FPMathAsync_hpp
+
+#include "FPValue.hpp"
+#include "FPComputeContext.hpp"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+
+
+/*!
+    非同期の計算を実行するエグゼキュータです。渡された関数をいずれかのスレッドで1度だけ実行します。
+ */
+typedef std::function<void(std::function<void()>)> FPExecutor;
+
+/*!
+    非同期の計算の設定です。
+ */
+struct FPAsyncOptions
+{
+    /*! 計算を実行するエグゼキュータ。空の場合はFPMathAsync::SetDefaultExecutor()で設定したものを使います */
+    FPExecutor  executor;
+
+    /*! 期限が設定されているかどうか */
+    bool        hasDeadline;
+
+    /*! 期限。これを過ぎると計算は中断され、結果はFPComputeCancelledになります */
+    std::chrono::steady_clock::time_point   deadline;
+
+    FPAsyncOptions()
+        : hasDeadline(false)
+    {}
+
+    /*! 現在時刻からtimeoutだけ経過した時点を期限に設定します。 */
+    FPAsyncOptions& SetTimeout(std::chrono::steady_clock::duration timeout)
+    {
+        hasDeadline = true;
+        deadline = std::chrono::steady_clock::now() + timeout;
+        return *this;
+    }
+};
+
+/*!
+    非同期の計算の結果を受け取るためのハンドルです。コピーしたハンドルは同じ計算を参照します。
+    キャンセルされた計算は次のチェックポイントで中断され、途中の数値はすべて解放されます。
+ */
+class FPAsyncResult
+{
+public:
+    /*! 計算の状態（コンテキストと結果）。ハンドルと実行中の計算で共有します */
+    struct State
+    {
+        FPComputeContext                context;
+        std::promise<FPValue>           promise;
+        std::shared_future<FPValue>     future;
+    };
+
+private:
+    std::shared_ptr<State>  state;
+
+public:
+    explicit FPAsyncResult(const std::shared_ptr<State>& state);
+
+public:
+    /*! 計算のキャンセルを要求します。 */
+    void        Cancel();
+
+    /*! 計算が終わっている（結果か例外が設定されている）かどうかを判定します。 */
+    bool        IsReady() const;
+
+    /*! 計算が終わるまで待ちます。 */
+    void        Wait() const;
+
+    /*! 計算が終わるまで最大timeoutだけ待ちます。終わっていればtrueをリターンします。 */
+    bool        WaitFor(std::chrono::steady_clock::duration timeout) const;
+
+    /*! 計算結果を取得します。終わっていなければ待ちます。計算が例外で終わった場合は、その例外を投げます。 */
+    FPValue     Get() const;
+
+    /*! 計算の進み具合を取得します。 */
+    FPProgress  Progress() const;
+
+};
+
+/*!
+    FPMathの計算を非同期に実行するための関数群です。
+    計算はエグゼキュータ上で実行され、FPAsyncResultからキャンセル・期限・進み具合の確認ができます。
+ */
+struct FPMathAsync
+{
+    /*! デフォルトのエグゼキュータを設定します。空の関数を渡すと、計算ごとに新しいスレッドを作る初期設定に戻ります。 */
+    static void             SetDefaultExecutor(FPExecutor executor);
+
+    /*!
+        任意の計算を非同期に実行します。
+        @param task         計算を行う関数。FPComputeContextのチェックポイントでキャンセルと期限が確認されます
+        @param targetDigits 進み具合の表示に使う目標の桁数
+        @param options      エグゼキュータと期限の設定
+     */
+    static FPAsyncResult    Run(std::function<FPValue()> task, int targetDigits, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! 自然対数の底eを非同期に求めます。 */
+    static FPAsyncResult    LogBaseE(int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! 円周率を非同期に求めます。 */
+    static FPAsyncResult    Pi(int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! サインを非同期に計算します。 */
+    static FPAsyncResult    Sin(const FPValue& angle, int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! コサインを非同期に計算します。 */
+    static FPAsyncResult    Cos(const FPValue& angle, int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! 累乗を非同期に計算します。 */
+    static FPAsyncResult    Pow(const FPValue& base, const FPValue& exponent, int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! 平方根を非同期に求めます。 */
+    static FPAsyncResult    Sqrt(const FPValue& value, int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+    /*! n乗根を非同期に求めます。 */
+    static FPAsyncResult    Root(const FPValue& value, int n, int dp, const FPAsyncOptions& options = FPAsyncOptions());
+
+};
+
+#endif /* FPMathAsync_hpp */
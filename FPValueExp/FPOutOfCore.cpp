@@ -0,0 +1,181 @@
+#include "FPOutOfCore.hpp"
+#include "FPComputeContext.hpp"
+#include "FPDiskLimbs.hpp"
+#include "IntLimbsHelper.hpp"
+#include "IntStringHelper.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+
+/*! 結果を切り捨てる前に余分に計算する桁数 */
+static const int kGuardDigits = 10;
+
+
+/*!
+    64ビットの数をリム配列に変換します。
+ */
+static IntLimbs LimbsFromUint64(uint64_t value)
+{
+    IntLimbs ret;
+    ret.push_back((uint32_t)value);
+    ret.push_back((uint32_t)(value >> 32));
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    eの級数の a+1〜b 項目を、binary splittingでまとめます。
+    P/Q = Σ_{k=a+1}^{b} a!/k!、Q = (a+1)(a+2)...b となるP, Qを求めます。
+ */
+static void SplitE(uint64_t a, uint64_t b, IntLimbs& P, IntLimbs& Q)
+{
+    if (b - a == 1) {
+        P = IntLimbs(1, 1);
+        Q = LimbsFromUint64(b);
+        return;
+    }
+    FPComputeContext::CheckPoint();
+    uint64_t m = (a + b) / 2;
+    IntLimbs P1, Q1, P2, Q2;
+    SplitE(a, m, P1, Q1);
+    SplitE(m, b, P2, Q2);
+    P = IntLimbs_Add(IntLimbs_Mult(P1, Q2), P2);
+    Q = IntLimbs_Mult(Q1, Q2);
+}
+
+/*!
+    小数点以下digits桁の精度に必要な、eの級数の項数を求めます（N! > 10^(digits + guard)となる最小のN）。
+ */
+static uint64_t TermCountForE(int digits)
+{
+    double target = (digits + kGuardDigits) * std::log(10.0);
+    uint64_t n = 1;
+    while (std::lgamma((double)n + 1.0) <= target) {
+        n++;
+    }
+    return n;
+}
+
+/*!
+    作業ファイルのパスを作成します。
+ */
+static std::string WorkPath(const std::string& workDir, const char *name, int generation)
+{
+    return workDir + "/e." + name + "." + std::to_string(generation);
+}
+
+/*!
+    チェックポイントを読み込みます。チェックポイントがないか、桁数が異なる場合はfalseをリターンします。
+ */
+static bool ReadCheckpoint(const std::string& workDir, int digits, uint64_t& nextTerm, int& generation)
+{
+    FILE *fp = fopen((workDir + "/e.checkpoint").c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    int savedDigits = 0;
+    unsigned long long savedNext = 0;
+    int savedGeneration = 0;
+    bool isValid = (fscanf(fp, "e %d %llu %d", &savedDigits, &savedNext, &savedGeneration) == 3 && savedDigits == digits);
+    fclose(fp);
+    if (isValid) {
+        nextTerm = savedNext;
+        generation = savedGeneration;
+    }
+    return isValid;
+}
+
+/*!
+    チェックポイントを書き込みます。一時ファイルに書いてから名前を変えるので、書き込み中に中断しても以前のチェックポイントは壊れません。
+ */
+static void WriteCheckpoint(const std::string& workDir, int digits, uint64_t nextTerm, int generation)
+{
+    std::string path = workDir + "/e.checkpoint";
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("Cannot write " + tmpPath + ": " + strerror(errno));
+    }
+    fprintf(fp, "e %d %llu %d\n", digits, (unsigned long long)nextTerm, generation);
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+    if (rename(tmpPath.c_str(), path.c_str()) < 0) {
+        throw std::runtime_error("Cannot write " + path + ": " + strerror(errno));
+    }
+}
+
+
+// eの計算（級数の和はディスク上、最後の割り算はメモリ上）
+void FPOutOfCore::ComputeESeriesOnDisk(int digits, const std::string& workDir, const std::string& outputPath, int chunkTerms, size_t blockLimbs)
+{
+    if (digits < 0 || chunkTerms < 1 || blockLimbs < 1) {
+        throw std::runtime_error("Invalid argument for out-of-core computation.");
+    }
+    uint64_t termCount = TermCountForE(digits);
+
+    // チェックポイントがあれば再開し、なければ P/Q = 0/1 から始める
+    uint64_t nextTerm = 0;
+    int generation = 0;
+    if (!ReadCheckpoint(workDir, digits, nextTerm, generation)) {
+        FPDiskLimbs P(WorkPath(workDir, "P", 0));
+        FPDiskLimbs Q(WorkPath(workDir, "Q", 0));
+        P.Assign(IntLimbs());
+        Q.Assign(IntLimbs(1, 1));
+        P.Sync();
+        Q.Sync();
+        WriteCheckpoint(workDir, digits, 0, 0);
+    }
+
+    // チャンクごとに P/Q <- (P * Qc + Pc) / (Q * Qc) と更新する
+    while (nextTerm < termCount) {
+        uint64_t end = std::min(nextTerm + (uint64_t)chunkTerms, termCount);
+        IntLimbs chunkP, chunkQ;
+        SplitE(nextTerm, end, chunkP, chunkQ);
+        {
+            FPDiskLimbs P(WorkPath(workDir, "P", generation));
+            FPDiskLimbs Q(WorkPath(workDir, "Q", generation));
+            FPDiskLimbs newP(WorkPath(workDir, "P", generation + 1));
+            FPDiskLimbs newQ(WorkPath(workDir, "Q", generation + 1));
+            FPDiskLimbs::Mult(P, chunkQ, newP, blockLimbs);
+            FPDiskLimbs::Add(newP, chunkP, newP);
+            FPDiskLimbs::Mult(Q, chunkQ, newQ, blockLimbs);
+            newP.Sync();
+            newQ.Sync();
+        }
+        WriteCheckpoint(workDir, digits, end, generation + 1);
+        unlink(WorkPath(workDir, "P", generation).c_str());
+        unlink(WorkPath(workDir, "Q", generation).c_str());
+        generation++;
+        nextTerm = end;
+        FPComputeContext::ReportProgress(nextTerm, (int)((double)digits * nextTerm / termCount));
+    }
+
+    // e = 1 + P/Q を小数点以下digits桁で切り捨てる（最後の割り算と10進数への変換はメモリ上で行う）
+    std::string result;
+    {
+        FPDiskLimbs P(WorkPath(workDir, "P", generation));
+        FPDiskLimbs Q(WorkPath(workDir, "Q", generation));
+        IntLimbs den = Q.ReadAll();
+        IntLimbs num = IntLimbs_Mult(IntLimbs_Add(P.ReadAll(), den), IntString_ToLimbs("1" + std::string(digits, '0')));
+        size_t k = std::max(num.size(), den.size() * 2);
+        IntLimbs quot = IntLimbs_DivModReciprocal(num, den, IntLimbs_Reciprocal(den, k), k).first;
+        result = IntString_FromLimbs(quot);
+    }
+    result.insert(1, (digits > 0)? ".": "");
+
+    FILE *fp = fopen(outputPath.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("Cannot write " + outputPath + ": " + strerror(errno));
+    }
+    fwrite(result.data(), 1, result.length(), fp);
+    fputc('\n', fp);
+    fclose(fp);
+}
@@ -0,0 +1,40 @@
+#ifndef FPOutOfCore_hpp
+#define FPOutOfCore_hpp
+
+#include <cstddef>
+#include <string>
+
+
+/*!
+    定数の級数の和を、ディスク上の作業ファイルを使って計算する関数群です。今のところ自然対数の底eだけに対応しています。
+    級数をchunkTerms項ずつのチャンクに分け、チャンク内はメモリ上でbinary splittingにより分数P/Qにまとめます。
+    それまでの合計の分数はFPDiskLimbsとして作業ディレクトリに置き、チャンクの分数とブロックごとに掛け合わせて更新します。
+    チャンクを1つ処理するたびに、途中結果のファイルをディスクに書き出してからチェックポイントを更新するので、
+    計算が途中で中断しても、同じ引数で呼び出し直せば最後のチェックポイントから再開します。
+    ディスクに置くのは級数の和の途中結果だけで、最後の割り算と10進数への変換はメモリ上で行います。
+    そのため、結果の桁数の数倍のメモリが必要です。
+    また、チャンクを順に合計へ掛け合わせるので、チャンク数をCとすると掛け算の量は合計の大きさのC倍程度になります。
+ */
+struct FPOutOfCore
+{
+    /*! ブロックごとの掛け算で、1つのブロックに含めるリム数のデフォルト値（4MB） */
+    static const size_t DefaultBlockLimbs = 1 << 20;
+
+    /*! 1つのチャンクに含める項数のデフォルト値 */
+    static const int    DefaultChunkTerms = 4096;
+
+    /*!
+        自然対数の底eを小数点以下digits桁まで計算し（digits桁より下は切り捨て）、"2.71828..."の形式でoutputPathに書き出します。
+        級数の和はディスク上で求めますが、最後の割り算と10進数への変換では分子と分母をメモリに読み込みます。
+        @param digits       小数点以下の桁数
+        @param workDir      途中結果とチェックポイントを置くディレクトリ（あらかじめ作成しておく必要があります）
+        @param outputPath   結果を書き出すファイルのパス
+        @param chunkTerms   1つのチャンクに含める項数
+        @param blockLimbs   ブロックごとの掛け算で、1つのブロックに含めるリム数
+     */
+    static void ComputeESeriesOnDisk(int digits, const std::string& workDir, const std::string& outputPath,
+                                     int chunkTerms = DefaultChunkTerms, size_t blockLimbs = DefaultBlockLimbs);
+
+};
+
+#endif /* FPOutOfCore_hpp */
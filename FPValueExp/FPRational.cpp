@@ -0,0 +1,224 @@
+#include "FPRational.hpp"
+#include "IntStringHelper.hpp"
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+
+/*!
+    10のn乗を表すリム配列を作成します。
+ */
+static IntLimbs PowerOfTen(int n)
+{
+    return IntString_ToLimbs("1" + std::string(n, '0'));
+}
+
+/*!
+    FPValueの数値文字列（先頭に0が付いていることがある）をリム配列に変換します。
+ */
+static IntLimbs ValueStringToLimbs(const std::string& vstr)
+{
+    return IntString_ToLimbs(IntString_Normalize(vstr));
+}
+
+/*!
+    1を表すリム配列を作成します。
+ */
+static IntLimbs One()
+{
+    return IntLimbs(1, 1);
+}
+
+
+// 符号・分子・分母を指定したコンストラクタ
+FPRational::FPRational(int sign, const IntLimbs& num, const IntLimbs& den, bool isReduced)
+    : sign((num.size() > 0)? sign: 1), num(num), den(den), isReduced(isReduced)
+{}
+
+// デフォルトコンストラクタ
+FPRational::FPRational()
+    : sign(1), num(), den(One()), isReduced(true)
+{}
+
+// 数値からのコンストラクタ
+FPRational::FPRational(const FPValue& value)
+    : FPRational(value, FPValue(1, "1", 0))
+{}
+
+// 分子と分母を指定したコンストラクタ
+FPRational::FPRational(const FPValue& numerator, const FPValue& denominator)
+    : FPRational()
+{
+    if (denominator.IsZero()) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+
+    // (n / 10^ndp) / (d / 10^ddp) = (n * 10^ddp) / (d * 10^ndp) の、10の累乗を片方にまとめる
+    int shift = denominator.dp - numerator.dp;
+    num = ValueStringToLimbs(numerator.vstr);
+    den = ValueStringToLimbs(denominator.vstr);
+    if (shift > 0) {
+        num = IntLimbs_Mult(num, PowerOfTen(shift));
+    } else if (shift < 0) {
+        den = IntLimbs_Mult(den, PowerOfTen(-shift));
+    }
+    sign = (num.size() > 0)? (numerator.sign * denominator.sign): 1;
+    isReduced = false;
+}
+
+// 大小比較
+int FPRational::Compare(const FPRational& value1, const FPRational& value2)
+{
+    int sign1 = value1.IsZero()? 0: value1.sign;
+    int sign2 = value2.IsZero()? 0: value2.sign;
+    if (sign1 != sign2) {
+        return (sign1 > sign2)? 1: -1;
+    }
+    if (sign1 == 0) {
+        return 0;
+    }
+
+    // 分母を払って分子同士を比較する
+    int comp = IntLimbs_Compare(IntLimbs_Mult(value1.num, value2.den), IntLimbs_Mult(value2.num, value1.den));
+    return comp * sign1;
+}
+
+// 符号を指定した足し算
+FPRational FPRational::AddSigned(const FPRational& value1, const FPRational& value2, int sign2)
+{
+    // 分母が同じ場合は通分しない
+    bool isSameDen = (IntLimbs_Compare(value1.den, value2.den) == 0);
+    IntLimbs n1 = isSameDen? value1.num: IntLimbs_Mult(value1.num, value2.den);
+    IntLimbs n2 = isSameDen? value2.num: IntLimbs_Mult(value2.num, value1.den);
+    IntLimbs den = isSameDen? value1.den: IntLimbs_Mult(value1.den, value2.den);
+
+    if (value1.sign == sign2) {
+        return FPRational(value1.sign, IntLimbs_Add(n1, n2), den, false);
+    }
+    int comp = IntLimbs_Compare(n1, n2);
+    if (comp >= 0) {
+        return FPRational(value1.sign, IntLimbs_Sub(n1, n2), den, false);
+    } else {
+        return FPRational(sign2, IntLimbs_Sub(n2, n1), den, false);
+    }
+}
+
+// 足し算
+FPRational FPRational::Add(const FPRational& value1, const FPRational& value2)
+{
+    return AddSigned(value1, value2, value2.sign);
+}
+
+// 引き算
+FPRational FPRational::Sub(const FPRational& minuend, const FPRational& subtrahend)
+{
+    return AddSigned(minuend, subtrahend, -subtrahend.sign);
+}
+
+// 掛け算
+FPRational FPRational::Mult(const FPRational& factor1, const FPRational& factor2)
+{
+    return FPRational(factor1.sign * factor2.sign, IntLimbs_Mult(factor1.num, factor2.num), IntLimbs_Mult(factor1.den, factor2.den), false);
+}
+
+// 割り算
+FPRational FPRational::Div(const FPRational& dividend, const FPRational& divisor)
+{
+    return Mult(dividend, divisor.Inverse());
+}
+
+// ゼロかどうかの判定
+bool FPRational::IsZero() const
+{
+    return (num.size() == 0);
+}
+
+// 約分
+void FPRational::Reduce()
+{
+    if (isReduced) {
+        return;
+    }
+    if (num.size() == 0) {
+        den = One();
+    } else {
+        IntLimbs g = IntLimbs_GCD(num, den);
+        if (IntLimbs_Compare(g, One()) != 0) {
+            num = IntLimbs_DivMod(num, g).first;
+            den = IntLimbs_DivMod(den, g).first;
+        }
+    }
+    isReduced = true;
+}
+
+// 約分した分数の作成
+FPRational FPRational::Reduced() const
+{
+    FPRational ret(*this);
+    ret.Reduce();
+    return ret;
+}
+
+// 符号の反転
+FPRational FPRational::Negate() const
+{
+    return FPRational(-sign, num, den, isReduced);
+}
+
+// 逆数
+FPRational FPRational::Inverse() const
+{
+    if (IsZero()) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+    return FPRational(sign, den, num, isReduced);
+}
+
+// 分子の取得
+FPValue FPRational::Numerator() const
+{
+    return FPValue(sign, IntString_FromLimbs(num), 0);
+}
+
+// 分母の取得
+FPValue FPRational::Denominator() const
+{
+    return FPValue(1, IntString_FromLimbs(den), 0);
+}
+
+// 小数への変換
+FPValue FPRational::ToFPValue(int dp, RoundMode mode) const
+{
+    assert(dp >= 0);
+    if (IsZero()) {
+        return FPValue();
+    }
+
+    // 分子を10^dp倍してから1回だけ割り算する
+    std::pair<IntLimbs, IntLimbs> div = IntLimbs_DivMod(IntLimbs_Mult(num, PowerOfTen(dp)), den);
+    IntLimbs& quot = div.first;
+    const IntLimbs& remain = div.second;
+
+    // 商の丸め（商の絶対値を1単位大きくするかどうか）
+    bool isRemainZero = (remain.size() == 0);
+    int halfCompare = isRemainZero? -1: IntLimbs_Compare(IntLimbs_Add(remain, remain), den);
+    bool isOdd = (quot.size() > 0 && (quot[0] & 1) != 0);
+    if (FPValue::IsQuotientRoundUp(mode, sign, isRemainZero, halfCompare, isOdd)) {
+        quot = IntLimbs_Add(quot, One());
+    }
+    if (quot.size() == 0) {
+        return FPValue();
+    }
+    return FPValue(sign, IntString_FromLimbs(quot), dp);
+}
+
+// 文字列への変換
+std::string FPRational::to_s() const
+{
+    std::string ret = (sign < 0 && !IsZero())? "-": "";
+    ret += IntString_FromLimbs(num);
+    ret += "/";
+    ret += IntString_FromLimbs(den);
+    return ret;
+}
@@ -0,0 +1,115 @@
+#ifndef FPRational_hpp
+#define FPRational_hpp
+
+#include "FPValue.hpp"
+#include "IntLimbsHelper.hpp"
+
+#include <string>
+
+
+/*!
+    分子と分母を任意の大きさの整数で持つ、誤差のない分数を表すクラスです。
+    FPValueから作成した値は 数値文字列 / 10^dp という分数になり、四則演算は掛け算と足し算だけで誤差なく計算します。
+    約分は演算のたびには行わず、Reduce()を呼び出した時にだけ行います。
+    割り算はToFPValue()で小数に変換する時に1回だけ行うので、途中で何度も割り算を行うよりも高速で、途中の丸め誤差もありません。
+ */
+class FPRational
+{
+    /*! 符号を表す数値。1か-1（0の場合は1） */
+    int         sign;
+
+    /*! 分子の絶対値 */
+    IntLimbs    num;
+
+    /*! 分母（常に正） */
+    IntLimbs    den;
+
+    /*! 約分済みかどうか */
+    bool        isReduced;
+
+    /*! 符号・分子・分母を指定して、この分数を初期化します。 */
+    FPRational(int sign, const IntLimbs& num, const IntLimbs& den, bool isReduced);
+
+    /*! 符号を指定した2つの分数の足し算を計算します。 */
+    static FPRational AddSigned(const FPRational& value1, const FPRational& value2, int sign2);
+
+public:
+    /*! 2つの分数の大小比較を行います。value1>value2のときは正の数を、同じ数であれば0を、value1<value2のときは負の数をリターンします。 */
+    static int Compare(const FPRational& value1, const FPRational& value2);
+
+    /*! 2つの分数の足し算を計算します。分母が同じ場合は分母をそのまま使います。 */
+    static FPRational Add(const FPRational& value1, const FPRational& value2);
+
+    /*! 2つの分数の引き算を計算します。 */
+    static FPRational Sub(const FPRational& minuend, const FPRational& subtrahend);
+
+    /*! 2つの分数の掛け算を計算します。 */
+    static FPRational Mult(const FPRational& factor1, const FPRational& factor2);
+
+    /*! 2つの分数の割り算を計算します（分子と分母を掛け合わせるだけで、実際の割り算は行いません）。divisorが0の場合は例外を投げます。 */
+    static FPRational Div(const FPRational& dividend, const FPRational& divisor);
+
+public:
+    /*! デフォルトコンストラクタ。分数を0で初期化します。 */
+    FPRational();
+
+    /*! コンストラクタ。数値を誤差なく分数に変換します。 */
+    FPRational(const FPValue& value);
+
+    /*!
+        コンストラクタ。numerator / denominator を表す分数を作成します。
+        @param numerator    分子
+        @param denominator  分母。0の場合は例外を投げます。
+     */
+    FPRational(const FPValue& numerator, const FPValue& denominator);
+
+public:
+    /*! この分数がゼロかどうかを判定します。 */
+    bool    IsZero() const;
+
+    /*! この分数が約分済みかどうかを判定します。 */
+    bool    IsReduced() const { return isReduced; }
+
+    /*! 分子と分母を最大公約数で割って約分します。 */
+    void    Reduce();
+
+    /*! 約分した分数を作成します。 */
+    FPRational Reduced() const;
+
+    /*! 符号を反転させた分数を作成します。 */
+    FPRational Negate() const;
+
+    /*! 逆数を作成します。この分数が0の場合は例外を投げます。 */
+    FPRational Inverse() const;
+
+    /*! 符号付きの分子を取得します。 */
+    FPValue Numerator() const;
+
+    /*! 分母を取得します。 */
+    FPValue Denominator() const;
+
+    /*!
+        この分数を、小数点以下dp桁の数値に変換します。分子を分母で割る割り算を1回だけ行います。
+        @param dp   小数点以下の桁数
+        @param mode 丸め方法（デフォルト値は通常の四捨五入を表すRoundMode_HalfUp）
+     */
+    FPValue ToFPValue(int dp, RoundMode mode = RoundMode_HalfUp) const;
+
+    /*! この分数を表す文字列を、"-22/7"のような形式でリターンします。 */
+    std::string to_s() const;
+
+public:
+    FPRational  operator+() const { return *this; }
+    FPRational  operator-() const { return Negate(); }
+    FPRational  operator+(const FPRational& other) const { return Add(*this, other); }
+    FPRational  operator-(const FPRational& other) const { return Sub(*this, other); }
+    FPRational  operator*(const FPRational& other) const { return Mult(*this, other); }
+    FPRational  operator/(const FPRational& other) const { return Div(*this, other); }
+    FPRational& operator+=(const FPRational& other) { *this = Add(*this, other); return *this; }
+    FPRational& operator-=(const FPRational& other) { *this = Sub(*this, other); return *this; }
+    FPRational& operator*=(const FPRational& other) { *this = Mult(*this, other); return *this; }
+    FPRational& operator/=(const FPRational& other) { *this = Div(*this, other); return *this; }
+
+};
+
+#endif /* FPRational_hpp */
@@ -0,0 +1,440 @@
+#include "FPTrace.hpp"
+#include "FPBinary.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+
+
+/*! トレースファイルのマジックナンバー */
+static const uint8_t kTraceMagic[3] = { 'F', 'P', 'T' };
+
+/*! 記録を指定するための環境変数の名前 */
+static const char *kTraceEnvName = "FPVALUE_TRACE";
+
+/*! スレッドごとのバッファをファイルに書き出す大きさ（バイト） */
+static const size_t kFlushBytes = 64 * 1024;
+
+/*! 引数の数値をそのまま記録したことを表すバイト */
+static const uint8_t kOperandValue = 0;
+
+/*! 引数の大きさだけを記録したことを表すバイト */
+static const uint8_t kOperandSize = 1;
+
+
+/*!
+    可変長整数（LEB128）を書き込みます。
+ */
+static void WriteVarint(uint64_t value, std::vector<uint8_t>& out)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+/*!
+    可変長整数（LEB128）を読み込みます。データが足りない場合は例外を投げます。
+ */
+static uint64_t ReadVarint(const uint8_t *& p, const uint8_t *end)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) {
+            throw std::runtime_error("Truncated FPTrace data.");
+        }
+        uint8_t b = *p++;
+        value |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in FPTrace data.");
+}
+
+/*!
+    符号付きの整数を、絶対値の小さい数ほど短くなるように符号なしの整数に変換します（ジグザグ符号化）。
+ */
+static uint64_t ZigZagEncode(int value)
+{
+    return ((uint64_t)(int64_t)value << 1) ^ (uint64_t)((int64_t)value >> 63);
+}
+
+/*!
+    ジグザグ符号化した整数を元に戻します。int型の範囲外の場合は例外を投げます。
+ */
+static int ZigZagDecode(uint64_t value)
+{
+    int64_t decoded = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    if (decoded < INT32_MIN || decoded > INT32_MAX) {
+        throw std::runtime_error("Integer out of range in FPTrace data.");
+    }
+    return (int)decoded;
+}
+
+
+struct ThreadTrace;
+
+/*!
+    記録先のファイルなど、すべてのスレッドで共有するトレースの状態です。
+ */
+struct TraceState
+{
+    /*! ファイルへの書き出しを排他制御するミューテックス */
+    std::mutex      mutex;
+
+    /*! 記録先のファイル（記録中でなければNULL） */
+    FILE            *fp;
+
+    /*! 記録を開始するたびに増やす番号（前の記録の残りを書き出さないために使います） */
+    std::atomic<uint64_t>   generation;
+
+    /*! 数値をそのまま記録する有効数字の最大の桁数 */
+    std::atomic<int>        maxValueDigits;
+
+    /*! 存在するスレッドごとのトレースの状態（Stop()ですべての記録を書き出すために使います） */
+    std::vector<ThreadTrace *>  threads;
+
+    TraceState()
+        : fp(nullptr), generation(0), maxValueDigits(0)
+    {}
+};
+
+/*!
+    プロセス全体で共有するトレースの状態を取得します。
+ */
+static TraceState& SharedState()
+{
+    static TraceState state;
+    return state;
+}
+
+/*!
+    スレッドごとのトレースの状態です。作成時に共有の状態に登録し、スレッドの終了時に、たまっている記録を書き出して登録を外します。
+    バッファは、そのスレッドとStop()を呼び出したスレッドの両方から触るので、mutexで排他制御します。
+    ロックするときは、必ず共有の状態のミューテックスを先にロックします。
+ */
+struct ThreadTrace
+{
+    /*! 演算の入れ子の深さ（このスレッドだけが触ります） */
+    int                     depth;
+
+    /*! バッファを排他制御するミューテックス */
+    std::mutex              mutex;
+
+    /*! バッファの記録を開始したときのgeneration */
+    uint64_t                generation;
+
+    /*! まだ書き出していない記録 */
+    std::vector<uint8_t>    buffer;
+
+    /*! bufferのうち、終わった演算の記録の大きさ（実行中の演算の記録は書き出さないため） */
+    size_t                  completeSize;
+
+    ThreadTrace();
+    ~ThreadTrace();
+};
+
+/*! 現在のスレッドのトレースの状態 */
+static thread_local ThreadTrace sThreadTrace;
+
+/*!
+    スレッドのバッファのうち、終わった演算の記録をファイルに書き出して、バッファから取り除きます。
+    記録を開始し直した後に残っていた前の記録や、記録を終了した後の記録は捨てます。
+    state.mutexをロックした状態で呼び出してください。
+ */
+static void WriteThreadTrace(TraceState& state, ThreadTrace& trace)
+{
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (trace.completeSize == 0) {
+        return;
+    }
+    if (state.fp && trace.generation == state.generation) {
+        fwrite(trace.buffer.data(), 1, trace.completeSize, state.fp);
+    }
+    trace.buffer.erase(trace.buffer.begin(), trace.buffer.begin() + trace.completeSize);
+    trace.completeSize = 0;
+}
+
+/*!
+    スレッドのバッファの、終わった演算の記録をファイルに書き出します。
+ */
+static void FlushThreadTrace(ThreadTrace& trace)
+{
+    TraceState& state = SharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    WriteThreadTrace(state, trace);
+}
+
+// スレッドの最初の記録での登録
+ThreadTrace::ThreadTrace()
+    : depth(0), generation(0), completeSize(0)
+{
+    TraceState& state = SharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.threads.push_back(this);
+}
+
+// スレッドの終了時の書き出しと登録の解除
+ThreadTrace::~ThreadTrace()
+{
+    TraceState& state = SharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    WriteThreadTrace(state, *this);
+    state.threads.erase(std::find(state.threads.begin(), state.threads.end(), this));
+}
+
+/*!
+    1つの引数を記録します。
+ */
+static void WriteOperand(const FPValue& value, int sign, int digitCount, int dp, int maxValueDigits, std::vector<uint8_t>& out)
+{
+    if (digitCount <= maxValueDigits) {
+        out.push_back(kOperandValue);
+        FPBinary::Encode(value, out);
+    } else {
+        out.push_back(kOperandSize);
+        WriteVarint(((uint64_t)digitCount << 1) | ((sign < 0)? 1: 0), out);
+        WriteVarint(ZigZagEncode(dp), out);
+    }
+}
+
+/*!
+    環境変数FPVALUE_TRACEが指定されていれば、起動時に記録を開始するためのオブジェクトです。
+    終了時には、メインスレッドの記録はスレッドごとの状態の破棄で書き出され、ファイルはプロセスの終了時に閉じられます。
+ */
+static struct TraceAutoStart
+{
+    TraceAutoStart()
+    {
+        const char *path = getenv(kTraceEnvName);
+        if (path && path[0] != '\0') {
+            try {
+                FPTrace::Start(path);
+            } catch (std::exception& e) {
+                fprintf(stderr, "%s: %s\n", kTraceEnvName, e.what());
+            }
+        }
+    }
+} sTraceAutoStart;
+
+
+std::atomic<bool> FPTrace::sIsEnabled(false);
+const uint8_t FPTrace::Version;
+
+
+// デフォルトの設定
+FPTraceOptions::FPTraceOptions()
+    : maxValueDigits(1000)
+{}
+
+// 記録の開始
+void FPTrace::Start(const std::string& path, const FPTraceOptions& options)
+{
+    if (IsEnabled()) {
+        Stop();
+    }
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        throw std::runtime_error("Cannot write " + path + ": " + strerror(errno));
+    }
+    fwrite(kTraceMagic, 1, 3, fp);
+    fputc(Version, fp);
+
+    TraceState& state = SharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.fp = fp;
+    state.generation++;
+    state.maxValueDigits = std::max(0, options.maxValueDigits);
+    sIsEnabled = true;
+}
+
+// 記録の終了
+void FPTrace::Stop()
+{
+    // 記録を止めてから、すべてのスレッドの終わった演算の記録を書き出して閉じる
+    TraceState& state = SharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    sIsEnabled = false;
+    for (ThreadTrace *trace : state.threads) {
+        WriteThreadTrace(state, *trace);
+    }
+    if (state.fp) {
+        fclose(state.fp);
+        state.fp = nullptr;
+    }
+}
+
+// 演算の記録の開始
+void FPTrace::Scope::Begin(FPTraceOp op, int dp, int aux, const FPValue *const *operands, size_t count)
+{
+    ThreadTrace& trace = sThreadTrace;
+    isActive = true;
+    if (trace.depth++ > 0) {
+        return;
+    }
+    isRecording = true;
+
+    // 記録を開始し直していれば、前の記録の残りを捨てる
+    TraceState& state = SharedState();
+    uint64_t generation = state.generation;
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (trace.generation != generation) {
+        trace.buffer.clear();
+        trace.completeSize = 0;
+        trace.generation = generation;
+    }
+
+    std::vector<uint8_t>& out = trace.buffer;
+    out.push_back((uint8_t)op);
+    WriteVarint(ZigZagEncode(dp), out);
+    WriteVarint(ZigZagEncode(aux), out);
+    WriteVarint(count, out);
+    int maxValueDigits = state.maxValueDigits;
+    for (size_t i = 0; i < count; i++) {
+        const FPValue& value = *operands[i];
+        WriteOperand(value, value.sign, (int)value.vstr.length(), value.dp, maxValueDigits, out);
+    }
+
+    // 記録にかかった時間を含めないように、最後に開始時刻を取得する
+    start = std::chrono::steady_clock::now();
+}
+
+// 演算の記録の終了
+void FPTrace::Scope::End()
+{
+    ThreadTrace& trace = sThreadTrace;
+    trace.depth--;
+    if (!isRecording) {
+        return;
+    }
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    bool isFull;
+    {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        WriteVarint((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), trace.buffer);
+        trace.completeSize = trace.buffer.size();
+        isFull = (trace.completeSize >= kFlushBytes);
+    }
+    if (isFull) {
+        FlushThreadTrace(trace);
+    }
+}
+
+// 記録しない範囲の開始
+FPTrace::Suppressor::Suppressor(bool isSuppressed)
+    : isSuppressed(isSuppressed)
+{
+    if (isSuppressed) {
+        sThreadTrace.depth++;
+    }
+}
+
+// 記録しない範囲の終了
+FPTrace::Suppressor::~Suppressor()
+{
+    if (isSuppressed) {
+        sThreadTrace.depth--;
+    }
+}
+
+// 演算の内部かどうか
+bool FPTrace::IsInsideOperation()
+{
+    return (sThreadTrace.depth > 0);
+}
+
+// トレースファイルの読み込み
+std::vector<FPTraceRecord> FPTrace::ReadFile(const std::string& path)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        throw std::runtime_error("Cannot read " + path + ": " + strerror(errno));
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(fp);
+
+    if (data.size() < 4 || !std::equal(kTraceMagic, kTraceMagic + 3, data.begin())) {
+        throw std::runtime_error("Not an FPTrace file: " + path);
+    }
+    if (data[3] != Version) {
+        throw std::runtime_error("Unsupported FPTrace version: " + path);
+    }
+
+    // 大きさだけを記録した数値は、同じ桁数の乱数に置き換える（ファイルごとに同じ値になるように種を固定する）
+    std::mt19937_64 random(20261019);
+    std::vector<FPTraceRecord> records;
+    const uint8_t *p = data.data() + 4;
+    const uint8_t *end = data.data() + data.size();
+    while (p < end) {
+        // 壊れた記録は、何番目の記録かを付けて報告する
+        FPTraceRecord record;
+        try {
+            uint8_t op = *p++;
+            if (op == 0 || op >= FPTraceOp_End) {
+                throw std::runtime_error("Unknown operation in FPTrace data.");
+            }
+            record.op = (FPTraceOp)op;
+            record.dp = ZigZagDecode(ReadVarint(p, end));
+            record.aux = ZigZagDecode(ReadVarint(p, end));
+            uint64_t count = ReadVarint(p, end);
+            if (count > (uint64_t)(end - p)) {
+                throw std::runtime_error("Truncated FPTrace data.");
+            }
+            record.operands.reserve((size_t)count);
+            for (uint64_t i = 0; i < count; i++) {
+                if (p >= end) {
+                    throw std::runtime_error("Truncated FPTrace data.");
+                }
+                uint8_t kind = *p++;
+                if (kind == kOperandValue) {
+                    size_t consumed = 0;
+                    record.operands.push_back(FPBinary::Decode(p, end - p, &consumed));
+                    p += consumed;
+                } else if (kind == kOperandSize) {
+                    uint64_t header = ReadVarint(p, end);
+                    int dp = ZigZagDecode(ReadVarint(p, end));
+                    uint64_t digitCount = header >> 1;
+                    if (digitCount == 0 || digitCount > (uint64_t)INT32_MAX) {
+                        throw std::runtime_error("Invalid operand size in FPTrace data.");
+                    }
+                    std::string vstr((size_t)digitCount, '0');
+                    for (size_t k = 0; k < vstr.length(); k++) {
+                        vstr[k] = (char)('0' + random() % 10);
+                    }
+                    vstr[0] = (char)('1' + random() % 9);
+                    vstr[vstr.length() - 1] = (char)('1' + random() % 9);
+                    record.operands.push_back(FPValue((header & 1)? -1: 1, vstr, dp));
+                } else {
+                    throw std::runtime_error("Unknown operand kind in FPTrace data.");
+                }
+            }
+            record.nanos = ReadVarint(p, end);
+        } catch (std::exception& e) {
+            throw std::runtime_error("Malformed record #" + std::to_string(records.size()) + " in " + path + ": " + e.what());
+        }
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+// 演算の種類の名前
+const char *FPTrace::OpName(FPTraceOp op)
+{
+    static const char *const kNames[FPTraceOp_End] = {
+        "?", "Add", "Sub", "Mult", "Div", "DivMod", "LogBaseE", "Pi", "Sin", "Cos",
+        "Pow", "Sqrt", "Root", "Log", "Exp", "SinBatch", "CosBatch", "ExpBatch",
+    };
+    return (op > 0 && op < FPTraceOp_End)? kNames[op]: "?";
+}
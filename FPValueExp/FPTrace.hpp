@@ -0,0 +1,199 @@
+#ifndef FPTrace_hpp
+#define FPTrace_hpp
+
+#include "FPValue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/*!
+    トレースに記録する演算の種類です。ファイルに記録する値なので、番号を変えてはいけません。
+ */
+enum FPTraceOp : uint8_t
+{
+    FPTraceOp_Add = 1,
+    FPTraceOp_Sub,
+    FPTraceOp_Mult,
+    FPTraceOp_Div,
+    FPTraceOp_DivMod,
+    FPTraceOp_LogBaseE,
+    FPTraceOp_Pi,
+    FPTraceOp_Sin,
+    FPTraceOp_Cos,
+    FPTraceOp_Pow,
+    FPTraceOp_Sqrt,
+    FPTraceOp_Root,
+    FPTraceOp_Log,
+    FPTraceOp_Exp,
+    FPTraceOp_SinBatch,
+    FPTraceOp_CosBatch,
+    FPTraceOp_ExpBatch,
+
+    /*! 演算の種類の個数より1大きい値 */
+    FPTraceOp_End,
+};
+
+/*!
+    トレースファイルから読み込んだ1回の演算の記録です。
+ */
+struct FPTraceRecord
+{
+    /*! 演算の種類 */
+    FPTraceOp   op;
+
+    /*! 小数点以下の桁数の引数（引数がない演算では0） */
+    int         dp;
+
+    /*! 演算ごとの追加の引数（Divは最後の桁を丸めるかどうか、DivModは丸め方法、Rootはn。それ以外は0） */
+    int         aux;
+
+    /*! 記録したときの実行時間（ナノ秒） */
+    uint64_t    nanos;
+
+    /*! 引数の数値 */
+    std::vector<FPValue>    operands;
+};
+
+/*!
+    トレースを記録するときの設定です。
+ */
+struct FPTraceOptions
+{
+    /*!
+        数値をそのまま記録する有効数字の最大の桁数。これより長い数値は桁数と小数点の位置だけを記録し、
+        読み込むときに同じ大きさの乱数に置き換えます（記録の時間とファイルの大きさを抑えるため）。
+     */
+    int     maxValueDigits;
+
+    /*! コンストラクタ。デフォルト値で初期化します。 */
+    FPTraceOptions();
+};
+
+/*!
+    FPValueの四則演算とFPMathの各関数の呼び出しを、引数・精度・実行時間とともにバイナリ形式のファイルに記録するトレーサーです。
+    FPReplayツールで同じ演算を実行し直して、本番の負荷での性能をオフラインで計測するために使います。
+
+    記録はStart()を呼ぶか、環境変数FPVALUE_TRACEにファイルのパスを指定して起動すると始まります。
+    記録していないときの各演算のオーバーヘッドは、アトミック変数を1回読み込むだけです。
+    演算の中から呼ばれた演算（Sinの中の掛け算など）は記録せず、一番外側の呼び出しだけを記録します。
+    記録はスレッドごとにメモリにためて、まとめてファイルに書き出します。
+    記録はバッファがいっぱいになったときか、スレッドの終了時か、Stop()で書き出されます。Stop()はすべてのスレッドの終わった演算の記録を書き出し、
+    その時点で実行中の演算は記録しません。
+
+    ファイルは、マジックナンバー"FPT"とバージョン番号に続けて、各演算の記録を並べた形式です。
+    - 記録: 演算の種類（1バイト）、dp、aux（ジグザグ符号化）、引数の個数を可変長整数で並べ、続けて各引数と、実行時間（ナノ秒）の可変長整数を格納します。
+    - 引数: 数値をそのまま記録した場合は0のバイトに続けてFPBinary形式の数値を、大きさだけを記録した場合は1のバイトに続けて
+      (有効数字の桁数 << 1) | (負の数なら1) と、dp（ジグザグ符号化）を可変長整数で格納します。
+ */
+struct FPTrace
+{
+    /*! トレースファイルのバージョン番号 */
+    static const uint8_t    Version = 2;
+
+    /*!
+        トレースの記録を開始します。すでに記録中の場合は、それまでの記録を書き出して閉じてから開始します。
+        ファイルを作成できない場合は例外を投げます。
+     */
+    static void     Start(const std::string& path, const FPTraceOptions& options = FPTraceOptions());
+
+    /*! すべてのスレッドの記録を書き出して、トレースの記録を終了します。 */
+    static void     Stop();
+
+    /*! トレースを記録中かどうかを判定します。 */
+    static bool     IsEnabled()
+    {
+        return sIsEnabled.load(std::memory_order_relaxed);
+    }
+
+    /*! トレースファイルを読み込みます。形式が正しくない場合は例外を投げます。 */
+    static std::vector<FPTraceRecord>   ReadFile(const std::string& path);
+
+    /*! 演算の種類の名前（"Add"など）を取得します。 */
+    static const char   *OpName(FPTraceOp op);
+
+public:
+    /*!
+        1回の演算を記録するためのクラスです。演算の関数の先頭で作成すると、デストラクタで実行時間とともに記録します。
+        引数はコンストラクタで記録するので、参照している数値が演算の途中で変わっても構いません。
+     */
+    class Scope
+    {
+        /*! このスコープで演算の入れ子の深さを増やしたかどうか */
+        bool        isActive;
+
+        /*! このスコープの演算を記録するかどうか（一番外側の呼び出しの場合） */
+        bool        isRecording;
+
+        /*! 演算の開始時刻 */
+        std::chrono::steady_clock::time_point   start;
+
+        /*! 記録を開始します。 */
+        void        Begin(FPTraceOp op, int dp, int aux, const FPValue *const *operands, size_t count);
+
+        /*! 記録を終了します。 */
+        void        End();
+
+    public:
+        /*! 引数が2個以下の演算のスコープを作成します。 */
+        Scope(FPTraceOp op, int dp, int aux, const FPValue *value1 = nullptr, const FPValue *value2 = nullptr)
+            : isActive(false), isRecording(false)
+        {
+            if (IsEnabled()) {
+                const FPValue *operands[2] = { value1, value2 };
+                Begin(op, dp, aux, operands, (value2? 2: (value1? 1: 0)));
+            }
+        }
+
+        /*! 数値の配列を引数にとる演算のスコープを作成します。 */
+        Scope(FPTraceOp op, int dp, const std::vector<FPValue>& values)
+            : isActive(false), isRecording(false)
+        {
+            if (IsEnabled()) {
+                std::vector<const FPValue *> operands(values.size());
+                for (size_t i = 0; i < values.size(); i++) {
+                    operands[i] = &values[i];
+                }
+                Begin(op, dp, 0, operands.data(), operands.size());
+            }
+        }
+
+        ~Scope()
+        {
+            if (isActive) {
+                End();
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /*!
+        記録中の演算から作成したスレッドで、その演算の内部の呼び出しを記録しないようにするためのクラスです。
+        isSuppressedがtrueのとき、オブジェクトが存在する間は現在のスレッドの演算を記録しません。
+     */
+    class Suppressor
+    {
+        bool        isSuppressed;
+
+    public:
+        explicit Suppressor(bool isSuppressed);
+        ~Suppressor();
+        Suppressor(const Suppressor&) = delete;
+        Suppressor& operator=(const Suppressor&) = delete;
+    };
+
+    /*! 現在のスレッドが、記録中の演算の内部を実行しているかどうかを判定します。 */
+    static bool     IsInsideOperation();
+
+private:
+    /*! 記録中かどうか */
+    static std::atomic<bool>    sIsEnabled;
+
+};
+
+#endif /* FPTrace_hpp */
@@ -0,0 +1,131 @@
+#include "FPTuning.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+
+/*! プロファイルを指定する環境変数の名前 */
+static const char *kProfileEnvName = "FPVALUE_TUNING_PROFILE";
+
+/*! プロファイルの値に許される最大値のデフォルト */
+static const int kMaxTuningValue = 1000000000;
+
+/*!
+    プロファイルのファイル上のキーと、対応するメンバ・許される最小値と最大値を表す構造体です。
+ */
+struct TuningKey
+{
+    const char  *name;
+    int FPTuningProfile::*member;
+    int         minValue;
+    int         maxValue;
+};
+
+/*! プロファイルのキーの一覧 */
+static const TuningKey kTuningKeys[] = {
+    { "karatsuba_limbs",        &FPTuningProfile::karatsubaLimbs,       2,  kMaxTuningValue },
+    { "simd_mult_min_limbs",    &FPTuningProfile::simdMultMinLimbs,     1,  kMaxTuningValue },
+    { "conv_base_digits",       &FPTuningProfile::convBaseDigits,       2,  kMaxTuningValue },
+    { "div_limbs_min_digits",   &FPTuningProfile::divLimbsMinDigits,    1,  kMaxTuningValue },
+    { "div_newton_min_limbs",   &FPTuningProfile::divNewtonMinLimbs,    2,  kMaxTuningValue },
+    { "limbs_mult_min_digits",  &FPTuningProfile::limbsMultMinDigits,   1,  9 },
+};
+
+
+// 組み込みのデフォルト値
+FPTuningProfile::FPTuningProfile()
+    : karatsubaLimbs(32), simdMultMinLimbs(8), convBaseDigits(128), divLimbsMinDigits(8), divNewtonMinLimbs(1024),
+      limbsMultMinDigits(4)
+{}
+
+/*!
+    プロセス全体で共有するプロファイルを取得します。最初の呼び出しでファイルから読み込みます。
+ */
+static FPTuningProfile& SharedProfile()
+{
+    static FPTuningProfile profile = []() {
+        FPTuningProfile loaded;
+        const char *envPath = getenv(kProfileEnvName);
+        FPTuning::Load((envPath && envPath[0] != '\0')? std::string(envPath): FPTuning::DefaultPath(), loaded);
+        return loaded;
+    }();
+    return profile;
+}
+
+// 現在のプロファイル
+const FPTuningProfile& FPTuning::Current()
+{
+    return SharedProfile();
+}
+
+// プロファイルの置き換え
+void FPTuning::Set(const FPTuningProfile& profile)
+{
+    SharedProfile() = profile;
+}
+
+// プロファイルの読み込み
+bool FPTuning::Load(const std::string& path, FPTuningProfile& profile)
+{
+    if (path.length() == 0) {
+        return false;
+    }
+    FILE *fp = fopen(path.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#') {
+            continue;
+        }
+        char *eq = strchr(line, '=');
+        if (!eq) {
+            continue;
+        }
+        *eq = '\0';
+        char *end = nullptr;
+        long value = strtol(eq + 1, &end, 10);
+        if (end == eq + 1) {
+            continue;
+        }
+        for (const TuningKey& key : kTuningKeys) {
+            if (strcmp(line, key.name) == 0 && value >= key.minValue && value <= key.maxValue) {
+                profile.*key.member = (int)value;
+            }
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+// プロファイルの書き出し
+void FPTuning::Save(const std::string& path, const FPTuningProfile& profile)
+{
+    FILE *fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("Cannot write " + path + ": " + strerror(errno));
+    }
+    fprintf(fp, "# FPValue tuning profile\n");
+    for (const TuningKey& key : kTuningKeys) {
+        fprintf(fp, "%s=%d\n", key.name, profile.*key.member);
+    }
+    bool isFailed = (ferror(fp) != 0);
+    isFailed = (fclose(fp) != 0) || isFailed;
+    if (isFailed) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+// デフォルトのプロファイルのパス
+std::string FPTuning::DefaultPath()
+{
+    const char *home = getenv("HOME");
+    if (!home || home[0] == '\0') {
+        return "";
+    }
+    return std::string(home) + "/.fpvalue_tuning";
+}
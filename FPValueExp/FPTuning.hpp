@@ -0,0 +1,64 @@
+#ifndef FPTuning_hpp
+#define FPTuning_hpp
+
+#include <string>
+
+
+/*!
+    計算アルゴリズムを切り替える境目（リム数・桁数）をまとめた構造体です。
+    デフォルトコンストラクタは組み込みのデフォルト値で初期化します。
+ */
+struct FPTuningProfile
+{
+    /*! 掛け算をKaratsuba法に切り替えるリム数（短い方の数のリム数） */
+    int     karatsubaLimbs;
+
+    /*! 筆算の掛け算にSIMD実装を使うリム数（短い方の数のリム数） */
+    int     simdMultMinLimbs;
+
+    /*! 10進文字列とリム配列の変換で、分割統治法をやめて単純な方法で変換する桁数 */
+    int     convBaseDigits;
+
+    /*! 整数文字列の割り算を、1桁ずつの筆算ではなくリム配列の割り算で計算する桁数（割られる数の桁数） */
+    int     divLimbsMinDigits;
+
+    /*! リム配列の割り算を、Knuthの筆算ではなくニュートン法で求めた逆数で計算するリム数（割る数と商の短い方のリム数） */
+    int     divNewtonMinLimbs;
+
+    /*! 整数文字列の掛け算を、リム配列に変換して計算する桁数（短い方の数の桁数。9以下） */
+    int     limbsMultMinDigits;
+
+    /*! コンストラクタ。組み込みのデフォルト値で初期化します。 */
+    FPTuningProfile();
+};
+
+/*!
+    計算アルゴリズムの切り替えに使うプロファイルを管理する関数群です。
+    最初にCurrent()が呼ばれたときに、環境変数FPVALUE_TUNING_PROFILEで指定されたファイル（指定がなければDefaultPath()）から
+    プロファイルを読み込みます。ファイルがなければ組み込みのデフォルト値を使います。
+    プロファイルはFPTuneツールでマシンごとに計測して作成します。
+ */
+struct FPTuning
+{
+    /*! 現在のプロファイルを取得します。 */
+    static const FPTuningProfile&   Current();
+
+    /*! 現在のプロファイルを置き換えます。計算を実行しているスレッドがないときに呼び出してください。 */
+    static void     Set(const FPTuningProfile& profile);
+
+    /*!
+        "key=value"形式の行からなるファイルを読み込んで、profileの対応する値を上書きします。
+        知らないキーと"#"で始まる行は無視します。
+        @return ファイルを読み込めればtrue、ファイルがなければfalse
+     */
+    static bool     Load(const std::string& path, FPTuningProfile& profile);
+
+    /*! プロファイルを"key=value"形式でファイルに書き出します。書き出せない場合は例外を投げます。 */
+    static void     Save(const std::string& path, const FPTuningProfile& profile);
+
+    /*! 環境変数で指定がないときに読み込むプロファイルのパス（$HOME/.fpvalue_tuning）を取得します。 */
+    static std::string  DefaultPath();
+
+};
+
+#endif /* FPTuning_hpp */
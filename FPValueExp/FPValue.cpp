@@ -1,10 +1,17 @@
 #include "FPValue.hpp"
+#include "DoubleHelper.hpp"
+#include "FPComputeContext.hpp"
 #include "IntStringHelper.hpp"
 #include "FPMath.hpp"
+#include "FPTrace.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <strstream>
 #include <stdexcept>
 
@@ -18,46 +25,142 @@
  */
 static void AdjustValueStringLengths(std::string& vstr1, int& dp1, std::string& vstr2, int& dp2)
 {
-    while (dp1 < dp2) {
-        vstr1 = vstr1 + "0";
-        dp1++;
+    if (dp1 < dp2) {
+        vstr1.append(dp2 - dp1, '0');
+        dp1 = dp2;
+    } else if (dp2 < dp1) {
+        vstr2.append(dp1 - dp2, '0');
+        dp2 = dp1;
     }
-    while (dp2 < dp1) {
-        vstr2 = vstr2 + "0";
-        dp2++;
-    }
-    while (vstr1.length() < vstr2.length()) {
-        vstr1 = "0" + vstr1;
-    }
-    while (vstr2.length() < vstr1.length()) {
-        vstr2 = "0" + vstr2;
+    if (vstr1.length() < vstr2.length()) {
+        vstr1.insert(0, vstr2.length() - vstr1.length(), '0');
+    } else if (vstr2.length() < vstr1.length()) {
+        vstr2.insert(0, vstr1.length() - vstr2.length(), '0');
     }
 }
 
 /*!
     数値を表す文字列の前後から、不要なゼロを削除します。
+    末尾の0は小数点の位置を動かして取り除くため、整数の末尾の0を削除するとdpはマイナスになります。
     @param vstr     数値文字列
     @param dp       小数点以下の数字の個数
  */
 static void RemoveRedundantZeros(std::string& vstr, int& dp)
 {
-    // 小数点以下の不要な0の削除
-    while (dp > 0) {
-        if (vstr[vstr.length()-1] == '0') {
-            vstr = vstr.substr(0, vstr.length()-1);
-            dp--;
-        } else {
-            break;
+    // 末尾の0の削除（小数点の位置を動かす）
+    size_t len = vstr.length();
+    size_t trailing = 0;
+    while (trailing < len && vstr[len-1-trailing] == '0') {
+        trailing++;
+    }
+    if (trailing == len) {
+        vstr = "0";
+        dp = 0;
+        return;
+    }
+    if (trailing > 0) {
+        vstr.erase(len - trailing);
+        dp -= (int)trailing;
+    }
+
+    // 先頭の0の削除
+    size_t leading = 0;
+    while (vstr[leading] == '0') {
+        leading++;
+    }
+    if (leading > 0) {
+        vstr.erase(0, leading);
+    }
+}
+
+/*!
+    数値文字列の中で最初に0でない数字が現れる位置を求めます。すべて0の場合は文字列の長さをリターンします。
+ */
+static int FindFirstNonZero(const std::string& vstr)
+{
+    int len = (int)vstr.length();
+    int i = 0;
+    while (i < len && vstr[i] == '0') {
+        i++;
+    }
+    return i;
+}
+
+/*!
+    数値を表す文字列を、小数点以下precision桁に丸めます。文字列をその場で書き換えます。
+    @param vstr     数値文字列
+    @param dp       小数点以下の数字の個数
+    @param precision    丸めた結果の小数点以下の桁数
+    @param mode     丸め方法
+    @param sign     数値の符号（RoundMode_Ceil, RoundMode_Floorの判定に使います）
+ */
+static void RoundValueString(std::string& vstr, int& dp, int precision, RoundMode mode, int sign)
+{
+    if (dp <= precision) {
+        return;
+    }
+
+    // 切り捨てる部分の先頭の数字と、それ以降に0以外の数字があるかどうか
+    // 数字が切り捨てる桁より下にしかない場合は、先頭の数字が0で、それ以降に0以外の数字があるものとする
+    int keepLen = (int)vstr.length() - (dp - precision);
+    int first = 0;
+    bool hasRest = false;
+    if (keepLen >= 0) {
+        first = vstr[keepLen] - '0';
+        for (size_t i = keepLen + 1; i < vstr.length(); i++) {
+            if (vstr[i] != '0') {
+                hasRest = true;
+                break;
+            }
+        }
+    } else {
+        keepLen = 0;
+        hasRest = (FindFirstNonZero(vstr) < (int)vstr.length());
+    }
+    bool isOdd = (keepLen > 0 && (vstr[keepLen-1] - '0') % 2 != 0);
+    vstr.resize(keepLen);
+    dp = precision;
+
+    // 絶対値を1単位大きくするかどうかを判定する
+    bool isRoundUp = false;
+    if (first > 0 || hasRest) {
+        switch (mode) {
+            case RoundMode_HalfUp:
+                isRoundUp = (first >= 5);
+                break;
+            case RoundMode_HalfDown:
+                isRoundUp = (first > 5 || (first == 5 && hasRest));
+                break;
+            case RoundMode_Ceil:
+                isRoundUp = (sign > 0);
+                break;
+            case RoundMode_Floor:
+                isRoundUp = (sign < 0);
+                break;
+            case RoundMode_Truncate:
+                break;
+            case RoundMode_HalfEven:
+                isRoundUp = (first > 5 || (first == 5 && (hasRest || isOdd)));
+                break;
         }
     }
 
-    // 整数部の不要な0の削除
-    int intLen = (int)vstr.length() - dp;
-    for (int i = 0; i < intLen - 1; i++) {
-        if (vstr[0] == '0') {
-            vstr = vstr.substr(1);
+    // 最後の桁から桁上がりを伝播させる
+    if (isRoundUp) {
+        int pos = (int)keepLen - 1;
+        while (pos >= 0 && vstr[pos] == '9') {
+            vstr[pos] = '0';
+            pos--;
+        }
+        if (pos >= 0) {
+            vstr[pos]++;
+        } else {
+            vstr.insert(0, 1, '1');
         }
     }
+    if (vstr.length() == 0) {
+        vstr = "0";
+    }
 }
 
 // 2つの数値の絶対値の大小比較
@@ -65,19 +168,31 @@ int FPValue::AbsCompare(const FPValue& value1, const FPValue& value2)
 {
     //printf("AbsCompare (%s, %s)\n", value1.to_s().c_str(), value2.to_s().c_str());
 
-    // 文字列と小数点の位置を取得して長さを揃える
-    std::string vstr1 = value1.vstr;
-    std::string vstr2 = value2.vstr;
-    int dp1 = value1.dp;
-    int dp2 = value2.dp;
-    AdjustValueStringLengths(vstr1, dp1, vstr2, dp2);
+    // 最上位の0でない数字の位置を求める
+    int len1 = (int)value1.vstr.length();
+    int len2 = (int)value2.vstr.length();
+    int top1 = FindFirstNonZero(value1.vstr);
+    int top2 = FindFirstNonZero(value2.vstr);
+
+    // どちらかがゼロの場合
+    if (top1 == len1 || top2 == len2) {
+        return ((top1 == len1)? 0: 1) - ((top2 == len2)? 0: 1);
+    }
 
-    // 上の桁から大小比較していく
-    for (int i = 0; i < vstr1.length(); i++) {
-        int v1 = (int)(vstr1[i] - '0');
-        int v2 = (int)(vstr2[i] - '0');
-        if (v1 != v2) {
-            return (v1 > v2)? 1: -1;
+    // 整数部の桁数（最上位の桁の位置）が異なれば、それで大小が決まる
+    int exp1 = len1 - value1.dp - top1;
+    int exp2 = len2 - value2.dp - top2;
+    if (exp1 != exp2) {
+        return (exp1 > exp2)? 1: -1;
+    }
+
+    // 上の桁から、コピーせずにそのまま大小比較していく
+    int count = std::max(len1 - top1, len2 - top2);
+    for (int i = 0; i < count; i++) {
+        char c1 = (top1 + i < len1)? value1.vstr[top1 + i]: '0';
+        char c2 = (top2 + i < len2)? value2.vstr[top2 + i]: '0';
+        if (c1 != c2) {
+            return (c1 > c2)? 1: -1;
         }
     }
 
@@ -102,6 +217,8 @@ int FPValue::Compare(const FPValue& value1, const FPValue& value2)
 // 2つの数値の足し算
 FPValue FPValue::Add(const FPValue& value1, const FPValue& value2)
 {
+    FPTrace::Scope trace(FPTraceOp_Add, 0, 0, &value1, &value2);
+
     //printf("Add (%s, %s)\n", value1.to_s().c_str(), value2.to_s().c_str());
 
     // どちらかがゼロならば、ゼロでない方の数値をそのままリターンする
@@ -143,6 +260,8 @@ FPValue FPValue::Add(const FPValue& value1, const FPValue& value2)
 // 2つの数値の引き算
 FPValue FPValue::Sub(const FPValue& minuend, const FPValue& subtrahend)
 {
+    FPTrace::Scope trace(FPTraceOp_Sub, 0, 0, &minuend, &subtrahend);
+
     //printf("Sub (%s, %s)\n", minuend.to_s().c_str(), subtrahend.to_s().c_str());
 
     // minuendが0ならsubtrahendの符号を反転させたものをリターンする
@@ -193,6 +312,8 @@ FPValue FPValue::Sub(const FPValue& minuend, const FPValue& subtrahend)
 // 2つの数値の掛け算
 FPValue FPValue::Mult(const FPValue& factor1, const FPValue& factor2)
 {
+    FPTrace::Scope trace(FPTraceOp_Mult, 0, 0, &factor1, &factor2);
+
     // どちらかがゼロならば、結果はゼロ
     if (factor1.IsZero() || factor2.IsZero()) {
         return FPValue();
@@ -211,6 +332,8 @@ FPValue FPValue::Mult(const FPValue& factor1, const FPValue& factor2)
 // 2つの数値の割り算
 FPValue FPValue::Div(const FPValue& dividend, const FPValue& divisor, int decimalPlace, bool roundLast)
 {
+    FPTrace::Scope trace(FPTraceOp_Div, decimalPlace, roundLast? 1: 0, &dividend, &divisor);
+
     assert(decimalPlace >= 0);
     //printf("Div (%s, %s, dplace=%d)\n", dividend.to_s().c_str(), divisor.to_s().c_str(), decimalPlace);
 
@@ -229,116 +352,279 @@ FPValue FPValue::Div(const FPValue& dividend, const FPValue& divisor, int decima
     dor_str = IntString_Normalize(dor_str);
 
     // 整数部の割り算
-    std::string result = "";
     std::pair<std::string, std::string> div = IntString_Div(remain_str, dor_str);
-    result = result + div.first;
+    std::string result = div.first;
+    int result_dp = 0;
     remain_str = div.second;
-
-    // 小数部の割り算
-    if (remain_str != "0" && decimalPlace > 0) {
-        std::string roundStr = "0.";
-        result = result + ".";
-        for (int i = 0; i < decimalPlace+1; i++) {
-            remain_str = remain_str + "0";
+    int sign = dividend.sign * divisor.sign;
+
+    // 小数部の割り算（丸めのために1桁多く計算する）
+    if (remain_str != "0") {
+        int count = roundLast? (decimalPlace + 1): decimalPlace;
+        for (int i = 0; i < count && remain_str != "0"; i++) {
+            FPComputeContext::CheckPoint();
+            remain_str.push_back('0');
             div = IntString_Div(remain_str, dor_str);
-            result = result + div.first;
+            result += div.first;
+            result_dp++;
             remain_str = div.second;
-            roundStr = roundStr + ((i < decimalPlace)? "0": "5");
         }
 
         // 最後の数の丸め
         if (roundLast) {
-            result = FPValue::Add(FPValue(result), FPValue(roundStr)).to_s();
-            // TODO: 桁数がおかしい場合がある。1/22を10桁表示する場合など。
-            result = result.substr(0, result.length() - 1);
-        } else {
-            result = result.substr(0, result.length()-1);
+            RoundValueString(result, result_dp, decimalPlace, RoundMode_HalfUp, sign);
         }
     }
 
-    // 符号をつける
-    if (dividend.sign * divisor.sign < 0) {
-        result = "-" + result;
+    return FPValue(sign, result, result_dp);
+}
+
+// 商と余りの計算
+std::pair<FPValue, FPValue> FPValue::DivMod(const FPValue& dividend, const FPValue& divisor, int decimalPlace, RoundMode mode)
+{
+    FPTrace::Scope trace(FPTraceOp_DivMod, decimalPlace, (int)mode, &dividend, &divisor);
+
+    assert(decimalPlace >= 0);
+
+    // ゼロ除算のチェック
+    if (divisor.IsZero()) {
+        throw std::runtime_error("Zero division is now allowed.");
     }
 
-    return FPValue(result);
+    // 小数点の位置を合わせて整数にし、割られる数を商の桁数だけずらしてから1回で割り算する
+    std::string dend_str = dividend.vstr;
+    int dend_dp = dividend.dp;
+    std::string dor_str = divisor.vstr;
+    int dor_dp = divisor.dp;
+    AdjustValueStringLengths(dend_str, dend_dp, dor_str, dor_dp);
+    dend_str.append(decimalPlace, '0');
+    dend_str = IntString_Normalize(dend_str);
+    dor_str = IntString_Normalize(dor_str);
+    std::pair<std::string, std::string> div = IntString_Div(dend_str, dor_str);
+    std::string quot_str = div.first;
+    std::string remain_str = div.second;
+
+    // 商の丸め（商の絶対値を1単位大きくするかどうか）
+    int quotSign = dividend.sign * divisor.sign;
+    int remainSign = dividend.sign;
+    bool isRemainZero = (remain_str == "0");
+    int halfCompare = isRemainZero? -1: IntString_Compare(IntString_Add(remain_str, remain_str), dor_str);
+    bool isOdd = ((quot_str[quot_str.length()-1] - '0') % 2 != 0);
+    if (IsQuotientRoundUp(mode, quotSign, isRemainZero, halfCompare, isOdd)) {
+        quot_str = IntString_Add(quot_str, "1");
+        remain_str = IntString_Sub(dor_str, remain_str);
+        remainSign = -remainSign;
+    }
+
+    // 余りは割られる数と同じ小数点の位置から、さらに商の桁数だけずれている
+    FPValue quot = (quot_str != "0")? FPValue(quotSign, quot_str, decimalPlace): FPValue();
+    FPValue remain = (remain_str != "0")? FPValue(remainSign, remain_str, dend_dp + decimalPlace): FPValue();
+    return std::make_pair(quot, remain);
 }
 
+// 商の絶対値を1単位大きくするかどうかの判定
+bool FPValue::IsQuotientRoundUp(RoundMode mode, int sign, bool isRemainderZero, int halfCompare, bool isOdd)
+{
+    if (isRemainderZero) {
+        return false;
+    }
+    switch (mode) {
+        case RoundMode_HalfUp:
+            return (halfCompare >= 0);
+        case RoundMode_HalfDown:
+            return (halfCompare > 0);
+        case RoundMode_HalfEven:
+            return (halfCompare > 0 || (halfCompare == 0 && isOdd));
+        case RoundMode_Ceil:
+            return (sign > 0);
+        case RoundMode_Floor:
+            return (sign < 0);
+        default:
+            return false;
+    }
+}
 
-// デフォルトコンストラクタ
-FPValue::FPValue()
-    : sign(1), vstr("0"), dp(0)
-{}
 
-// コンストラクタ。"3.14159", "+3.14", "-2.6352"といった文字列を元に初期化する。
-FPValue::FPValue(const char *cNormalValueExp)
+/*!
+    並べ替えのための64ビットのキーを作成します。
+    キーの大小は数値の大小と矛盾しません（キーが等しい場合のみ、数値を比較し直す必要があります）。
+    上位から、符号（1ビット）・10進指数（16ビット）・上位14桁の数字（47ビット）の順に詰め込み、負の数は反転させます。
+    指数の欄の1と65535は、範囲外の小さい値と大きい値のために空けておきます。
+ */
+static uint64_t MakeSortKey(int sign, const std::string& vstr, int dp)
 {
-    // 初期化
-    sign = 1;
-    dp = 0;
-    std::string normalValueExp = cNormalValueExp;
+    const uint64_t signBit = (uint64_t)1 << 63;
+    int len = (int)vstr.length();
+    int top = FindFirstNonZero(vstr);
+    if (top == len) {
+        return signBit;
+    }
 
-    // 文字列のパース
-    bool hasDecimalPointAppeared = false;
-    for (int i = 0; i < normalValueExp.length(); i++) {
-        char c = normalValueExp[i];
-        // 符号
-        if (i == 0 && (c == '+' || c == '-')) {
-            sign = (c == '+')? 1: -1;
+    // 10進指数（範囲外の値は、範囲内のどの値よりも小さいか大きいキーにまとめて、数値の比較に任せる）
+    int exp = len - dp - top + 32768;
+    bool isOutOfRange = (exp < 2 || exp > 65534);
+    exp = std::max(1, std::min(65535, exp));
+
+    // 上位14桁の数字（10^14 < 2^47）
+    uint64_t digits = 0;
+    for (int i = 0; i < 14 && !isOutOfRange; i++) {
+        digits = digits * 10 + ((top + i < len)? (uint64_t)(vstr[top + i] - '0'): 0);
+    }
+
+    uint64_t mag = ((uint64_t)exp << 47) | digits;
+    return (sign > 0)? (signBit | mag): (signBit - mag);
+}
+
+// 昇順に並べ替えたときのインデックスの配列
+std::vector<size_t> FPValue::ArgSort(const std::vector<FPValue>& values)
+{
+    size_t count = values.size();
+    if (count == 0) {
+        return std::vector<size_t>();
+    }
+    std::vector<uint64_t> keys(count);
+    std::vector<size_t> indices(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = MakeSortKey(values[i].sign, values[i].vstr, values[i].dp);
+        indices[i] = i;
+    }
+
+    // キーを16ビットずつ、下位から安定な計数ソートで並べ替える（LSD基数ソート）
+    std::vector<uint64_t> tmpKeys(count);
+    std::vector<size_t> tmpIndices(count);
+    std::vector<size_t> counts(65536 + 1);
+    for (int shift = 0; shift < 64; shift += 16) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < count; i++) {
+            counts[((keys[i] >> shift) & 0xffff) + 1]++;
         }
-        // 小数点以下
-        else if (hasDecimalPointAppeared) {
-            if (c == '.') {
-                std::strstream sstr;
-                sstr << "Redundant dot appeared: index=" << i;
-                throw std::runtime_error(sstr.str());
-            } else if (isdigit(c)) {
-                vstr += c;
-                dp++;
-            } else {
-                std::strstream sstr;
-                sstr << "Unknown character appeared (decimal part): " << c << " (index=" << i << ")";
-                throw std::runtime_error(sstr.str());
-            }
+        if (counts[((keys[0] >> shift) & 0xffff) + 1] == count) {
+            // すべて同じ値なので並べ替える必要がない
+            continue;
         }
-        // 整数部
-        else {
-            if (c == '.') {
-                hasDecimalPointAppeared = true;
-            } else if (isdigit(c)) {
-                vstr += c;
-            } else {
-                std::strstream sstr;
-                sstr << "Unknown character appeared (integer part): " << c << " (index=" << i << ")";
-                throw std::runtime_error(sstr.str());
-            }
+        for (int b = 0; b < 65536; b++) {
+            counts[b + 1] += counts[b];
         }
+        for (size_t i = 0; i < count; i++) {
+            size_t pos = counts[(keys[i] >> shift) & 0xffff]++;
+            tmpKeys[pos] = keys[i];
+            tmpIndices[pos] = indices[i];
+        }
+        keys.swap(tmpKeys);
+        indices.swap(tmpIndices);
     }
 
-    // 前後の不要な0を削除する
-    RemoveRedundantZeros(vstr, dp);
+    // キーが同じ範囲だけ、数値そのものを比較して並べ替える
+    size_t begin = 0;
+    while (begin < count) {
+        size_t end = begin + 1;
+        while (end < count && keys[end] == keys[begin]) {
+            end++;
+        }
+        if (end - begin > 1) {
+            std::stable_sort(indices.begin() + begin, indices.begin() + end, [&values](size_t a, size_t b) {
+                return FPValue::Compare(values[a], values[b]) < 0;
+            });
+        }
+        begin = end;
+    }
 
-    // マイナスの0は許容しない
-    if (vstr == "0" && dp == 0) {
-        sign = 1;
+    return indices;
+}
+
+// 昇順に並べ替える
+void FPValue::Sort(std::vector<FPValue>& values)
+{
+    std::vector<size_t> indices = ArgSort(values);
+    std::vector<FPValue> sorted;
+    sorted.reserve(values.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        sorted.push_back(std::move(values[indices[i]]));
+    }
+    values.swap(sorted);
+}
+
+// doubleから最も短い10進数への変換
+FPValue FPValue::FromDoubleShortest(double value)
+{
+    if (!std::isfinite(value)) {
+        throw std::runtime_error("NaN or infinity cannot be converted to FPValue.");
     }
+    FPValue ret;
+    if (value == 0) {
+        return ret;
+    }
+    uint64_t digits = 0;
+    int exponent = 0;
+    Double_ShortestDigits(std::fabs(value), digits, exponent);
+    ret.sign = (value < 0)? -1: 1;
+    ret.vstr = std::to_string(digits);
+    ret.dp = -exponent;
+    return ret;
+}
+
+
+// デフォルトコンストラクタ
+FPValue::FPValue()
+    : sign(1), vstr("0"), dp(0)
+{}
+
+// コンストラクタ。"3.14159", "+3.14", "-2.6352"といった文字列を元に初期化する。
+FPValue::FPValue(const char *cNormalValueExp)
+{
+    Parse(cNormalValueExp, strlen(cNormalValueExp));
 }
 
 // コンストラクタ。"3.14159", "+3.14", "-2.6352"といった文字列を元に初期化する。
 FPValue::FPValue(const std::string& normalValueExp)
+{
+    Parse(normalValueExp.c_str(), normalValueExp.length());
+}
+
+// コンストラクタ。doubleの値を誤差なく10進数に展開して初期化する。
+FPValue::FPValue(double value)
+    : sign(1), vstr("0"), dp(0)
+{
+    if (!std::isfinite(value)) {
+        throw std::runtime_error("NaN or infinity cannot be converted to FPValue.");
+    }
+    if (value == 0) {
+        return;
+    }
+    int exponent = 0;
+    Double_ExactDigits(std::fabs(value), vstr, exponent);
+    dp = -exponent;
+    sign = (value < 0)? -1: 1;
+}
+
+// コンストラクタ。文字列をコピーせずに、指定された範囲の文字を元に初期化する。
+FPValue::FPValue(const char *str, size_t length)
+{
+    Parse(str, length);
+}
+
+// "3.14159", "+3.14", "-2.6352", "1.5e-300"といった文字列をパースして、この数値を初期化する。
+void FPValue::Parse(const char *str, size_t length)
 {
     // 初期化
     sign = 1;
     dp = 0;
+    vstr.clear();
+    vstr.reserve(length);
 
     // 文字列のパース
     bool hasDecimalPointAppeared = false;
-    for (int i = 0; i < normalValueExp.length(); i++) {
-        char c = normalValueExp[i];
+    for (int i = 0; i < (int)length; i++) {
+        char c = str[i];
         // 符号
         if (i == 0 && (c == '+' || c == '-')) {
             sign = (c == '+')? 1: -1;
         }
+        // 指数部（小数点の位置を動かす）
+        else if (c == 'e' || c == 'E') {
+            dp -= ParseExponent(str + i + 1, length - i - 1);
+            break;
+        }
         // 小数点以下
         else if (hasDecimalPointAppeared) {
             if (c == '.') {
@@ -368,6 +654,11 @@ FPValue::FPValue(const std::string& normalValueExp)
         }
     }
 
+    // 数字が1つもない場合はエラー
+    if (vstr.length() == 0) {
+        throw std::runtime_error("No digits appeared.");
+    }
+
     // 前後の不要な0を削除する
     RemoveRedundantZeros(vstr, dp);
 
@@ -377,6 +668,35 @@ FPValue::FPValue(const std::string& normalValueExp)
     }
 }
 
+// 指数部の文字列のパース
+int FPValue::ParseExponent(const char *str, size_t length)
+{
+    const int kMaxExponent = 100000000;
+    size_t pos = 0;
+    int expSign = 1;
+    if (pos < length && (str[pos] == '+' || str[pos] == '-')) {
+        expSign = (str[pos] == '+')? 1: -1;
+        pos++;
+    }
+    if (pos == length) {
+        throw std::runtime_error("No digits appeared in the exponent.");
+    }
+    int exponent = 0;
+    for (; pos < length; pos++) {
+        char c = str[pos];
+        if (!isdigit(c)) {
+            std::strstream sstr;
+            sstr << "Unknown character appeared (exponent): " << c;
+            throw std::runtime_error(sstr.str());
+        }
+        exponent = exponent * 10 + (c - '0');
+        if (exponent > kMaxExponent) {
+            throw std::runtime_error("Exponent is out of range.");
+        }
+    }
+    return exponent * expSign;
+}
+
 // コンストラクタ。符号、数値文字列、小数点以下の数字の個数を元に初期化する。
 FPValue::FPValue(int _sign, std::string _vstr, int _dp)
 {
@@ -386,25 +706,11 @@ FPValue::FPValue(int _sign, std::string _vstr, int _dp)
     for (int i = 0; i < _vstr.length(); i++) {
         assert(isdigit(_vstr[i]));
     }
-    assert(_dp >= 0);
 
     // それぞれの値をメンバ変数にコピー
     sign = (_sign > 0)? 1: -1;
     vstr = _vstr;
     dp = _dp;
-    while (dp > vstr.length()) {
-        vstr = "0" + vstr;
-    }
-
-    // 小数点以下の不要な0の削除
-    while (dp > 0) {
-        if (vstr[vstr.length()-1] == '0') {
-            vstr = vstr.substr(0, vstr.length()-1);
-            dp--;
-        } else {
-            break;
-        }
-    }
 
     // 前後の不要な0を削除する
     RemoveRedundantZeros(vstr, dp);
@@ -420,6 +726,11 @@ FPValue::FPValue(const FPValue& value)
     : sign(value.sign), vstr(value.vstr), dp(value.dp)
 {}
 
+// ムーブ・コンストラクタ
+FPValue::FPValue(FPValue&& value)
+    : sign(value.sign), vstr(std::move(value.vstr)), dp(value.dp)
+{}
+
 // この数値がゼロかどうかを判定
 bool FPValue::IsZero() const
 {
@@ -432,6 +743,44 @@ FPValue FPValue::Negate() const
     return FPValue((sign > 0)? -1: 1, vstr, dp);
 }
 
+// 丸め
+FPValue FPValue::Round(int precision, RoundMode mode) const
+{
+    assert(precision >= 0);
+    if (dp <= precision) {
+        return *this;
+    }
+    std::string rounded = vstr;
+    int rounded_dp = dp;
+    RoundValueString(rounded, rounded_dp, precision, mode, sign);
+    return FPValue(sign, rounded, rounded_dp);
+}
+
+// 整数部の文字列
+std::string FPValue::IntegerPart() const
+{
+    int intLen = (int)vstr.length() - dp;
+    if (intLen <= 0) {
+        return "0";
+    }
+    if (dp < 0) {
+        return vstr + std::string(-dp, '0');
+    }
+    return vstr.substr(0, intLen);
+}
+
+// 小数部の文字列
+std::string FPValue::DecimalPart() const
+{
+    if (dp <= 0) {
+        return "";
+    }
+    if ((int)vstr.length() < dp) {
+        return std::string(dp - vstr.length(), '0') + vstr;
+    }
+    return vstr.substr(vstr.length() - dp);
+}
+
 // 代入演算子のオーバーロード
 FPValue& FPValue::operator=(const FPValue& other)
 {
@@ -441,6 +790,15 @@ FPValue& FPValue::operator=(const FPValue& other)
     return *this;
 }
 
+// ムーブ代入演算子のオーバーロード
+FPValue& FPValue::operator=(FPValue&& other)
+{
+    sign = other.sign;
+    vstr = std::move(other.vstr);
+    dp = other.dp;
+    return *this;
+}
+
 // 単項プラス演算子のオーバーロード
 FPValue FPValue::operator+() const
 {
@@ -480,8 +838,7 @@ FPValue FPValue::operator/(const FPValue& other) const
 // 剰余演算子のオーバーロード
 FPValue FPValue::operator%(const FPValue& other) const
 {
-    FPValue quot = FPValue::Div(*this, other, 0, false);
-    return (*this - other * quot);
+    return FPValue::DivMod(*this, other, 0, RoundMode_Truncate).second;
 }
 
 // 累乗演算子のオーバーロード
@@ -533,6 +890,13 @@ FPValue::operator const char *() const
     return str_buffer.c_str();
 }
 
+// 最も近いdoubleの値への変換
+double FPValue::ToDouble() const
+{
+    double value = Double_FromDigits(vstr.data(), vstr.length(), -dp);
+    return (sign < 0)? -value: value;
+}
+
 // C++文字列へのキャストのサポート
 FPValue::operator std::string() const
 {
@@ -542,24 +906,27 @@ FPValue::operator std::string() const
 // FPValueを表す文字列表現に変換する。
 std::string FPValue::to_s() const
 {
-    str_buffer = vstr;
-    bool hasDecimalPoint = (dp > 0);
-    if (hasDecimalPoint) {
-        hasDecimalPoint = false;
-        for (int i = (int)str_buffer.length() - dp; i < str_buffer.length(); i++) {
-            if (str_buffer[i] != '0') {
-                hasDecimalPoint = true;
-                break;
-            }
+    // 補う0が多すぎる場合は指数表記にする
+    const int kMaxPaddingZeros = 20;
+    int len = (int)vstr.length();
+    int paddingZeros = (dp < 0)? -dp: std::max(0, dp - len);
+    if (paddingZeros > kMaxPaddingZeros) {
+        str_buffer = vstr.substr(0, 1);
+        if (len > 1) {
+            str_buffer += ".";
+            str_buffer.append(vstr, 1, std::string::npos);
         }
-    }
-    if (hasDecimalPoint) {
-        str_buffer.insert(str_buffer.length() - dp, ".");
-    } else if (dp > 0) {
-        str_buffer = str_buffer.substr(0, str_buffer.length() - dp);
-    }
-    if (str_buffer[0] == '.') {
-        str_buffer = "0" + str_buffer;
+        str_buffer += "e" + std::to_string(len - 1 - dp);
+    } else if (dp <= 0) {
+        str_buffer = vstr;
+        str_buffer.append(-dp, '0');
+    } else if (len <= dp) {
+        str_buffer = "0.";
+        str_buffer.append(dp - len, '0');
+        str_buffer += vstr;
+    } else {
+        str_buffer = vstr;
+        str_buffer.insert(len - dp, ".");
     }
     if (sign < 0) {
         str_buffer = "-" + str_buffer;
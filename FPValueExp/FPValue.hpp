@@ -2,9 +2,17 @@
 #define FPValue_hpp
 
 #include <string>
+#include <utility>
+#include <vector>
 
 
 struct FPMath;
+struct FPBinary;
+class FPAccumulator;
+class FPRational;
+class FPDivisor;
+class FPDigitStream;
+struct FPTrace;
 
 
 enum RoundMode {
@@ -22,6 +30,9 @@ enum RoundMode {
 
     /*! 数値を0に近づけるように丸めます。 */
     RoundMode_Truncate,
+
+    /*! 数値をもっとも近い値に丸めます。真ん中の値は最後の桁が偶数になる方に丸められます。いわゆる銀行家の丸めです。 */
+    RoundMode_HalfEven,
 };
 
 /*!
@@ -32,15 +43,31 @@ class FPValue
     /*! 符号を表す数値。1か-1 */
     int         sign;
 
-    /*! 数値を表す10進数の数字のみからなる文字列 */
+    /*! 数値を表す10進数の数字のみからなる文字列（有効数字のみで、前後に0は付きません。ゼロは"0"です） */
     std::string vstr;
 
-    /*! 小数点以下の数字の個数 */
+    /*! 小数点以下の数字の個数。数値はvstr × 10^(-dp)で、大きな整数ではマイナスになります（1e300はvstrが"1"、dpが-300） */
     int         dp;
 
     /*! to_s()サポートのための文字列 */
     mutable std::string str_buffer;
 
+    /*! "3.14159", "+3.14", "-2.6352", "1.5e-300"といった文字列をパースして、この数値を初期化します。 */
+    void Parse(const char *str, size_t length);
+
+    /*! 指数部の"-300"といった文字列をパースして、指数の値をリターンします。 */
+    static int ParseExponent(const char *str, size_t length);
+
+    /*!
+        割り算の商を丸めるときに、商の絶対値を1単位大きくするかどうかを判定します（DivMod, FPRational, FPDivisorで共通）。
+        @param mode             丸め方法
+        @param sign             商の符号（1か-1）
+        @param isRemainderZero  余りが0かどうか（0の場合は丸めない）
+        @param halfCompare      余りの2倍と割る数の大小比較の結果（余りの2倍の方が大きければ正の数）
+        @param isOdd            切り捨てた商の最後の桁が奇数かどうか
+     */
+    static bool IsQuotientRoundUp(RoundMode mode, int sign, bool isRemainderZero, int halfCompare, bool isOdd);
+
 public:
     /*! 2つの数値の絶対値の大小比較を行います。|value1|>|value2|のときは正の数を、同じ数であれば0を、|value1|<|value2|のときは負の数をリターンします。 */
     static int AbsCompare(const FPValue& value1, const FPValue& value2);
@@ -68,36 +95,85 @@ public:
      */
     static FPValue Div(const FPValue& dividend, const FPValue& divisor, int decimalPlace, bool roundLast);
 
+    /*!
+        2つの数値の割り算の商と余りを、1回の割り算でまとめて計算します。
+        商は小数点以下decimalPlace桁に丸められ、余りは dividend - 商 * divisor を満たす値になります。
+        @param dividend 割られる数
+        @param divisor  割る数
+        @param decimalPlace 商を小数点以下何桁まで計算するか（デフォルト値は0）
+        @param mode         商の丸め方法（デフォルト値は0に近づけるRoundMode_Truncate）
+        @return 商と余りのペア
+     */
+    static std::pair<FPValue, FPValue> DivMod(const FPValue& dividend, const FPValue& divisor, int decimalPlace = 0, RoundMode mode = RoundMode_Truncate);
+
+    /*!
+        数値の配列を昇順に並べ替えます。
+        各数値から固定長のキー（符号・桁数・上位の数字）を取り出して基数ソートし、キーが同じ数値だけをCompare()で比較します。
+        等しい数値同士の順序は保たれます（安定ソート）。
+     */
+    static void Sort(std::vector<FPValue>& values);
+
+    /*!
+        数値の配列を昇順に並べ替えたときの、各要素の元のインデックスの配列を作成します。
+        Sort()と同じ方法で並べ替え、等しい数値同士の順序は保たれます。
+     */
+    static std::vector<size_t> ArgSort(const std::vector<FPValue>& values);
+
+    /*!
+        doubleの値を、読み戻すと同じ値になる最も短い10進数に変換します（Ryuのアルゴリズム）。例えば0.1は0.1になります。
+        NaNや無限大の場合は例外を投げます。
+     */
+    static FPValue FromDoubleShortest(double value);
+
 public:
     /*! デフォルトコンストラクタ。数値を0で初期化します。 */
     FPValue();
 
     /*!
         コンストラクタ。
-        符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった文字列を元に、この数値を初期化します。
+        符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった文字列や、"1.5e-300"といった指数表記の文字列を元に、この数値を初期化します。
         @param normalValueExp 符号・数値・小数点を含む数値を表す文字列
      */
     FPValue(const char *normalValueExp);
 
     /*!
         コンストラクタ。
-        符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった文字列を元に、この数値を初期化します。
+        符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった文字列や、"1.5e-300"といった指数表記の文字列を元に、この数値を初期化します。
         @param normalValueExp 符号・数値・小数点を含む数値を表す文字列
      */
     FPValue(const std::string& normalValueExp);
 
+    /*!
+        コンストラクタ。
+        文字列の一部（メモリマップしたファイル上のフィールドなど）を、コピーせずにそのままパースしてこの数値を初期化します。
+        @param str      数値を表す文字列の先頭
+        @param length   数値を表す文字列の長さ
+     */
+    FPValue(const char *str, size_t length);
+
     /*!
         コンストラクタ。
         符号・数値文字列・小数点の位置をそれぞれ個別に指定して、この数値を初期化します。
         @param sign 正の数なら0より大きい値を、負の数なら0より小さい値を指定します。
         @param vstr 数値文字列。符号や小数点を含みません。
-        @param dp   小数点以下の数字の数。3.14の場合は2、整数123の場合は0となります。
+        @param dp   小数点以下の数字の数。3.14の場合は2、整数123の場合は0となります。マイナスの値を指定すると、数値文字列の後ろに0が続くものとします。
      */
     FPValue(int sign, std::string vstr, int dp);
 
+    /*!
+        コンストラクタ。
+        doubleの値（2進数）を誤差なく10進数に展開して、この数値を初期化します。
+        例えば0.1は0.1000000000000000055511151231257827021181583404541015625になります。NaNや無限大の場合は例外を投げます。
+        @param value    変換する値
+     */
+    explicit FPValue(double value);
+
     /*! コピー・コンストラクタ */
     FPValue(const FPValue& value);
 
+    /*! ムーブ・コンストラクタ */
+    FPValue(FPValue&& value);
+
 public:
     /*! この数値がゼロかどうかを判定します。 */
     bool IsZero() const;
@@ -123,6 +199,9 @@ public:
     /*! 代入演算子のオーバーロード */
     FPValue& operator=(const FPValue& other);
 
+    /*! ムーブ代入演算子のオーバーロード */
+    FPValue& operator=(FPValue&& other);
+
     /*! 単項プラス演算子のオーバーロード */
     FPValue operator+() const;
 
@@ -169,14 +248,27 @@ public:
     operator std::string() const;
 
 public:
-    /*! この数値を表す文字列を、符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった形式でリターンします。 */
+    /*!
+        この数値を表す文字列を、符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった形式でリターンします。
+        有効数字の前後に20個を超える0を補う必要がある場合は、"1.5e-300"といった指数表記でリターンします。
+     */
     std::string to_s() const;
 
     /*! この数値を表すC言語文字列を、符号・数値・小数点を含む"3.14159", "+3.14", "-2.6352"といった形式でリターンします。 */
     const char *c_str() const;
 
+    /*! この数値に最も近いdoubleの値をリターンします（真ん中の値は偶数の方に丸めます。大きすぎる場合は無限大になります）。 */
+    double ToDouble() const;
+
 public:
     friend FPMath;
+    friend FPBinary;
+    friend FPAccumulator;
+    friend FPRational;
+    friend FPDivisor;
+    friend FPDigitStream;
+    friend FPTrace;
+    template <int Digits, int Scale> friend class FixedDecimal;
 
 };
 
@@ -0,0 +1,388 @@
+#ifndef FixedDecimal_hpp
+#define FixedDecimal_hpp
+
+#include "FPValue.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+
+__extension__ typedef __int128             FDInt128;
+__extension__ typedef unsigned __int128    FDUInt128;
+
+
+/*!
+    FixedDecimalの演算で使う、128ビット・256ビット整数の補助関数群です。
+ */
+struct FixedDecimalHelper
+{
+    /*! 10のn乗（0 <= n <= 38） */
+    static constexpr FDUInt128 Pow10(int n)
+    {
+        FDUInt128 ret = 1;
+        for (int i = 0; i < n; i++) {
+            ret *= 10;
+        }
+        return ret;
+    }
+
+    /*! 128ビット同士の掛け算を、64ビット×4の256ビット整数（下位から格納）として計算します。 */
+    static void Mult256(FDUInt128 a, FDUInt128 b, uint64_t out[4])
+    {
+        uint64_t a0 = (uint64_t)a, a1 = (uint64_t)(a >> 64);
+        uint64_t b0 = (uint64_t)b, b1 = (uint64_t)(b >> 64);
+        FDUInt128 p00 = (FDUInt128)a0 * b0;
+        FDUInt128 p01 = (FDUInt128)a0 * b1;
+        FDUInt128 p10 = (FDUInt128)a1 * b0;
+        FDUInt128 p11 = (FDUInt128)a1 * b1;
+        FDUInt128 mid = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+        out[0] = (uint64_t)p00;
+        out[1] = (uint64_t)mid;
+        FDUInt128 high = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+        out[2] = (uint64_t)high;
+        out[3] = (uint64_t)(high >> 64);
+    }
+
+    /*! 256ビット整数を64ビットの数で割り、余りをリターンします（その場で計算）。 */
+    static uint64_t DivSmall256(uint64_t value[4], uint64_t divisor)
+    {
+        FDUInt128 rem = 0;
+        for (int i = 3; i >= 0; i--) {
+            FDUInt128 t = (rem << 64) | value[i];
+            value[i] = (uint64_t)(t / divisor);
+            rem = t % divisor;
+        }
+        return (uint64_t)rem;
+    }
+
+    /*! 256ビット整数を128ビットの数で割り、余りをリターンします（その場で計算）。 */
+    static FDUInt128 Div256(uint64_t value[4], FDUInt128 divisor)
+    {
+        if ((divisor >> 64) == 0) {
+            return DivSmall256(value, (uint64_t)divisor);
+        }
+        FDUInt128 rem = 0;
+        uint64_t quot[4] = { 0, 0, 0, 0 };
+        for (int i = 255; i >= 0; i--) {
+            bool carry = ((rem >> 127) != 0);
+            rem = (rem << 1) | ((value[i / 64] >> (i % 64)) & 1);
+            if (carry || rem >= divisor) {
+                rem -= divisor;
+                quot[i / 64] |= (uint64_t)1 << (i % 64);
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            value[i] = quot[i];
+        }
+        return rem;
+    }
+
+    /*!
+        丸めによって商の絶対値を1増やすかどうかを判定します。
+        @param mode         丸め方法
+        @param isNegative   結果が負の数かどうか
+        @param isInexact    切り捨てた部分が0でないかどうか
+        @param halfCompare  切り捨てた部分と、最後の桁の半分との大小比較結果
+        @param isOdd        切り捨てた後の商の最後の桁が奇数かどうか
+     */
+    static bool ShouldRoundAway(RoundMode mode, bool isNegative, bool isInexact, int halfCompare, bool isOdd)
+    {
+        if (!isInexact) {
+            return false;
+        }
+        switch (mode) {
+            case RoundMode_HalfUp:
+                return (halfCompare >= 0);
+            case RoundMode_HalfDown:
+                return (halfCompare > 0);
+            case RoundMode_Ceil:
+                return !isNegative;
+            case RoundMode_Floor:
+                return isNegative;
+            case RoundMode_Truncate:
+                return false;
+            case RoundMode_HalfEven:
+                return (halfCompare > 0 || (halfCompare == 0 && isOdd));
+        }
+        return false;
+    }
+
+    /*! 剰余と割る数から、剰余と割る数の半分との大小比較結果を求めます。 */
+    static int CompareHalf(FDUInt128 rem, FDUInt128 divisor)
+    {
+        FDUInt128 rest = divisor - rem;
+        return (rem > rest)? 1: ((rem < rest)? -1: 0);
+    }
+
+    /*! 符号なし128ビット整数を10進数の文字列に変換します。 */
+    static std::string ToString(FDUInt128 value)
+    {
+        char buf[48];
+        int pos = sizeof(buf);
+        do {
+            buf[--pos] = (char)('0' + (int)(value % 10));
+            value /= 10;
+        } while (value > 0);
+        return std::string(buf + pos, sizeof(buf) - pos);
+    }
+};
+
+
+/*!
+    有効数字Digits桁・小数点以下Scale桁の固定小数点数を表すクラスです。
+    値は10^Scale倍した整数として1つのメンバ変数に保持し、ヒープを使いません。
+    Digitsが18以下なら64ビット整数、38以下なら128ビット整数を使います。
+    自明にコピー可能（trivially copyable）なので、配列はmemcpyでコピーできます。
+ */
+template <int Digits, int Scale>
+class FixedDecimal
+{
+    static_assert(Digits >= 1 && Digits <= 38, "FixedDecimal supports 1 to 38 digits.");
+    static_assert(Scale >= 0 && Scale <= Digits, "FixedDecimal scale must be between 0 and Digits.");
+
+public:
+    /*! 値を保持する整数の型 */
+    typedef typename std::conditional<(Digits <= 18), int64_t, FDInt128>::type Rep;
+
+private:
+    /*! 10^Scale倍した値 */
+    Rep     raw;
+
+    /*! 絶対値の上限（10^Digits） */
+    static constexpr FDUInt128 Limit()
+    {
+        return FixedDecimalHelper::Pow10(Digits);
+    }
+
+    /*! 絶対値と符号から数値を作成します。桁あふれした場合は例外を投げます。 */
+    static FixedDecimal FromMagnitude(FDUInt128 mag, bool isNegative)
+    {
+        if (mag >= Limit()) {
+            throw std::overflow_error("FixedDecimal overflow.");
+        }
+        return FromRaw(isNegative? -(Rep)mag: (Rep)mag);
+    }
+
+    /*! 絶対値を取得します。 */
+    FDUInt128 Magnitude() const
+    {
+        return (raw < 0)? (FDUInt128)(-(FDInt128)raw): (FDUInt128)raw;
+    }
+
+public:
+    /*! 2つの数値の大小比較を行います。value1>value2のときは正の数を、同じ数であれば0を、value1<value2のときは負の数をリターンします。 */
+    static int Compare(const FixedDecimal& value1, const FixedDecimal& value2)
+    {
+        return (value1.raw > value2.raw)? 1: ((value1.raw < value2.raw)? -1: 0);
+    }
+
+    /*! 2つの数値の足し算を計算します。 */
+    static FixedDecimal Add(const FixedDecimal& value1, const FixedDecimal& value2)
+    {
+        Rep result;
+        if (__builtin_add_overflow(value1.raw, value2.raw, &result) || result >= (Rep)Limit() || result <= -(Rep)Limit()) {
+            throw std::overflow_error("FixedDecimal overflow.");
+        }
+        return FromRaw(result);
+    }
+
+    /*! 2つの数値の引き算を計算します。 */
+    static FixedDecimal Sub(const FixedDecimal& minuend, const FixedDecimal& subtrahend)
+    {
+        Rep result;
+        if (__builtin_sub_overflow(minuend.raw, subtrahend.raw, &result) || result >= (Rep)Limit() || result <= -(Rep)Limit()) {
+            throw std::overflow_error("FixedDecimal overflow.");
+        }
+        return FromRaw(result);
+    }
+
+    /*! 2つの数値の掛け算を計算し、小数点以下Scale桁に丸めます。 */
+    static FixedDecimal Mult(const FixedDecimal& factor1, const FixedDecimal& factor2, RoundMode mode = RoundMode_HalfUp)
+    {
+        bool isNegative = ((factor1.raw < 0) != (factor2.raw < 0));
+        const FDUInt128 scale = FixedDecimalHelper::Pow10(Scale);
+        FDUInt128 quot;
+        FDUInt128 rem;
+
+        if (Digits <= 18) {
+            // 64ビット同士の積は128ビットに収まる
+            FDUInt128 product = factor1.Magnitude() * factor2.Magnitude();
+            quot = product / scale;
+            rem = product % scale;
+        } else {
+            // 128ビット同士の積を256ビットで計算し、64ビットに収まる10の累乗で2回に分けて割る
+            uint64_t product[4];
+            FixedDecimalHelper::Mult256(factor1.Magnitude(), factor2.Magnitude(), product);
+            const int scale1 = (Scale < 19)? Scale: 19;
+            const uint64_t d1 = (uint64_t)FixedDecimalHelper::Pow10(scale1);
+            const uint64_t d2 = (uint64_t)FixedDecimalHelper::Pow10(Scale - scale1);
+            uint64_t r1 = FixedDecimalHelper::DivSmall256(product, d1);
+            uint64_t r2 = FixedDecimalHelper::DivSmall256(product, d2);
+            if (product[2] != 0 || product[3] != 0) {
+                throw std::overflow_error("FixedDecimal overflow.");
+            }
+            quot = ((FDUInt128)product[1] << 64) | product[0];
+            rem = (FDUInt128)r2 * d1 + r1;
+        }
+
+        int halfCompare = FixedDecimalHelper::CompareHalf(rem, scale);
+        if (FixedDecimalHelper::ShouldRoundAway(mode, isNegative, rem != 0, halfCompare, (quot & 1) != 0)) {
+            quot++;
+        }
+        return FromMagnitude(quot, isNegative);
+    }
+
+    /*! 2つの数値の割り算を計算し、小数点以下Scale桁に丸めます。 */
+    static FixedDecimal Div(const FixedDecimal& dividend, const FixedDecimal& divisor, RoundMode mode = RoundMode_HalfUp)
+    {
+        // ゼロ除算のチェック
+        if (divisor.raw == 0) {
+            throw std::runtime_error("Zero division is now allowed.");
+        }
+
+        bool isNegative = ((dividend.raw < 0) != (divisor.raw < 0));
+        FDUInt128 dor = divisor.Magnitude();
+        uint64_t num[4];
+        FixedDecimalHelper::Mult256(dividend.Magnitude(), FixedDecimalHelper::Pow10(Scale), num);
+        FDUInt128 rem = FixedDecimalHelper::Div256(num, dor);
+        if (num[2] != 0 || num[3] != 0) {
+            throw std::overflow_error("FixedDecimal overflow.");
+        }
+        FDUInt128 quot = ((FDUInt128)num[1] << 64) | num[0];
+
+        int halfCompare = FixedDecimalHelper::CompareHalf(rem, dor);
+        if (FixedDecimalHelper::ShouldRoundAway(mode, isNegative, rem != 0, halfCompare, (quot & 1) != 0)) {
+            quot++;
+        }
+        return FromMagnitude(quot, isNegative);
+    }
+
+    /*! 10^Scale倍した整数値から数値を作成します。 */
+    static FixedDecimal FromRaw(Rep raw)
+    {
+        FixedDecimal ret;
+        ret.raw = raw;
+        return ret;
+    }
+
+public:
+    /*! デフォルトコンストラクタ。数値を0で初期化します。 */
+    FixedDecimal()
+        : raw(0)
+    {}
+
+    /*!
+        コンストラクタ。FPValueの値を元に、この数値を初期化します。
+        小数点以下Scale桁を超える部分は、指定した丸め方法で丸めます。桁あふれした場合は例外を投げます。
+        @param value    元になる数値
+        @param mode     丸め方法（デフォルト値は通常の四捨五入を表すRoundMode_HalfUp）
+     */
+    explicit FixedDecimal(const FPValue& value, RoundMode mode = RoundMode_HalfUp)
+        : raw(0)
+    {
+        const std::string& vstr = value.vstr;
+        int keepLen = (int)vstr.length() - ((value.dp > Scale)? (value.dp - Scale): 0);
+
+        // 残す桁を整数として読み込む
+        FDUInt128 mag = 0;
+        for (int i = 0; i < keepLen; i++) {
+            if (mag >= Limit() / 10) {
+                throw std::overflow_error("FixedDecimal overflow.");
+            }
+            mag = mag * 10 + (FDUInt128)(vstr[i] - '0');
+        }
+        for (int i = value.dp; i < Scale; i++) {
+            if (mag >= Limit() / 10) {
+                throw std::overflow_error("FixedDecimal overflow.");
+            }
+            mag *= 10;
+        }
+
+        // 切り捨てる桁の丸め（数字がすべて切り捨てる桁より下にある場合は、切り捨てる先頭の数字は0になる）
+        if (keepLen < (int)vstr.length()) {
+            int first = (keepLen >= 0)? (vstr[keepLen] - '0'): 0;
+            bool hasRest = false;
+            for (int i = std::max(keepLen + 1, 0); i < (int)vstr.length(); i++) {
+                if (vstr[i] != '0') {
+                    hasRest = true;
+                    break;
+                }
+            }
+            int halfCompare = (first > 5 || (first == 5 && hasRest))? 1: ((first == 5)? 0: -1);
+            if (FixedDecimalHelper::ShouldRoundAway(mode, value.sign < 0, first > 0 || hasRest, halfCompare, (mag & 1) != 0)) {
+                mag++;
+            }
+        }
+        *this = FromMagnitude(mag, value.sign < 0);
+    }
+
+public:
+    /*! 10^Scale倍した整数値を取得します。 */
+    Rep Raw() const
+    {
+        return raw;
+    }
+
+    /*! この数値がゼロかどうかを判定します。 */
+    bool IsZero() const
+    {
+        return (raw == 0);
+    }
+
+    /*! この数値をFPValueに変換します。変換で誤差は生じません。 */
+    FPValue ToFPValue() const
+    {
+        return FPValue((raw < 0)? -1: 1, FixedDecimalHelper::ToString(Magnitude()), Scale);
+    }
+
+    /*! この数値を表す文字列を、FPValue::to_s()と同じ形式でリターンします。 */
+    std::string to_s() const
+    {
+        return ToFPValue().to_s();
+    }
+
+public:
+    /*! 単項プラス演算子のオーバーロード */
+    FixedDecimal operator+() const { return *this; }
+
+    /*! 単項マイナス演算子のオーバーロード */
+    FixedDecimal operator-() const { return FromRaw(-raw); }
+
+    /*! 加算演算子のオーバーロード */
+    FixedDecimal operator+(const FixedDecimal& other) const { return Add(*this, other); }
+
+    /*! 減算演算子のオーバーロード */
+    FixedDecimal operator-(const FixedDecimal& other) const { return Sub(*this, other); }
+
+    /*! 乗算演算子のオーバーロード */
+    FixedDecimal operator*(const FixedDecimal& other) const { return Mult(*this, other); }
+
+    /*! 除算演算子のオーバーロード */
+    FixedDecimal operator/(const FixedDecimal& other) const { return Div(*this, other); }
+
+    /*! 加算代入演算子のオーバーロード */
+    FixedDecimal& operator+=(const FixedDecimal& other) { *this = Add(*this, other); return *this; }
+
+    /*! 減算代入演算子のオーバーロード */
+    FixedDecimal& operator-=(const FixedDecimal& other) { *this = Sub(*this, other); return *this; }
+
+    /*! 乗算代入演算子のオーバーロード */
+    FixedDecimal& operator*=(const FixedDecimal& other) { *this = Mult(*this, other); return *this; }
+
+    /*! 除算代入演算子のオーバーロード */
+    FixedDecimal& operator/=(const FixedDecimal& other) { *this = Div(*this, other); return *this; }
+
+    /*! 比較演算子のオーバーロード */
+    bool operator==(const FixedDecimal& other) const { return raw == other.raw; }
+    bool operator!=(const FixedDecimal& other) const { return raw != other.raw; }
+    bool operator<(const FixedDecimal& other) const { return raw < other.raw; }
+    bool operator<=(const FixedDecimal& other) const { return raw <= other.raw; }
+    bool operator>(const FixedDecimal& other) const { return raw > other.raw; }
+    bool operator>=(const FixedDecimal& other) const { return raw >= other.raw; }
+
+};
+
+#endif /* FixedDecimal_hpp */
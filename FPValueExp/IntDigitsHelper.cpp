@@ -0,0 +1,366 @@
+#include "IntDigitsHelper.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INTDIGITS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+/*!
+    足し算・引き算のカーネルの関数テーブルです。
+ */
+struct IntDigitsKernel
+{
+    const char  *name;
+    int         (*add)(const char *digits1, const char *digits2, char *out, size_t n);
+    int         (*sub)(const char *minuend, const char *subtrahend, char *out, size_t n);
+};
+
+
+/*!
+    スカラー実装の足し算。下の桁から順に、carryを伝播させながら計算します。
+ */
+static int AddScalar(const char *digits1, const char *digits2, char *out, size_t n, int carry)
+{
+    for (size_t i = n; i-- > 0;) {
+        int v = (digits1[i] - '0') + (digits2[i] - '0') + carry;
+        carry = (v >= 10)? 1: 0;
+        out[i] = (char)('0' + v - carry * 10);
+    }
+    return carry;
+}
+
+/*!
+    スカラー実装の引き算。下の桁から順に、borrowを伝播させながら計算します。
+ */
+static int SubScalar(const char *minuend, const char *subtrahend, char *out, size_t n, int borrow)
+{
+    for (size_t i = n; i-- > 0;) {
+        int v = (minuend[i] - '0') - (subtrahend[i] - '0') - borrow;
+        borrow = (v < 0)? 1: 0;
+        out[i] = (char)('0' + v + borrow * 10);
+    }
+    return borrow;
+}
+
+static int AddScalarKernel(const char *digits1, const char *digits2, char *out, size_t n)
+{
+    return AddScalar(digits1, digits2, out, n, 0);
+}
+
+static int SubScalarKernel(const char *minuend, const char *subtrahend, char *out, size_t n)
+{
+    return SubScalar(minuend, subtrahend, out, n, 0);
+}
+
+
+#if INTDIGITS_X86_SIMD
+
+/*!
+    64ビット整数のビットの並びを反転します。
+ */
+static inline uint64_t ReverseBits(uint64_t x)
+{
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(x);
+}
+
+/*!
+    各レーンの桁上がりの発生（generate）と伝播（propagate）のマスクから、各レーンに入ってくる桁上がりのマスクを求めます。
+    マスクのビットiはメモリ上のi番目のレーンを表し、桁上がりは下の桁（番号の大きいレーン）から上の桁へ伝わります。
+    ビットを反転して桁の重みの順に並べると、propagate + (generate << 1 | carry) の足し算1回で、すべてのレーンの桁上がりが求まります。
+    @param generate     そのレーンで桁上がりが発生するレーンのマスク
+    @param propagate    下から桁上がりが来たときだけ桁上がりするレーンのマスク
+    @param lanes        レーン数（16, 32, 64のいずれか）
+    @param carry        下のブロックからの桁上がり。上のブロックへの桁上がりで上書きされます
+ */
+static inline uint64_t ResolveCarries(uint64_t generate, uint64_t propagate, int lanes, int& carry)
+{
+    uint64_t g = ReverseBits(generate) >> (64 - lanes);
+    uint64_t p = ReverseBits(propagate) >> (64 - lanes);
+    uint64_t b = (g << 1) | (uint64_t)carry;
+    uint64_t r = p + b;
+    if (lanes < 64) {
+        carry = (int)((r >> lanes) & 1);
+        r &= ((uint64_t)1 << lanes) - 1;
+    } else {
+        carry = (int)((g >> 63) | ((r < p)? 1: 0));
+    }
+    return ReverseBits(r ^ p) >> (64 - lanes);
+}
+
+/*!
+    SSE4.2実装の足し算（16桁ずつ）
+ */
+__attribute__((target("sse4.2")))
+static int AddSSE42(const char *digits1, const char *digits2, char *out, size_t n)
+{
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i bits = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+    int carry = 0;
+    size_t pos = n;
+    while (pos >= 16) {
+        pos -= 16;
+        __m128i a = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(digits1 + pos)), zero);
+        __m128i b = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(digits2 + pos)), zero);
+        __m128i s = _mm_add_epi8(a, b);
+        uint64_t generate = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(s, nine));
+        uint64_t propagate = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(s, nine));
+        uint64_t cmask = ResolveCarries(generate, propagate, 16, carry);
+
+        // マスクのビットをバイトごとの-1/0に展開して足し込む
+        __m128i c = _mm_shuffle_epi8(_mm_set1_epi16((short)cmask), spread);
+        c = _mm_cmpeq_epi8(_mm_and_si128(c, bits), bits);
+        s = _mm_sub_epi8(s, c);
+        s = _mm_sub_epi8(s, _mm_and_si128(_mm_cmpgt_epi8(s, nine), ten));
+        _mm_storeu_si128((__m128i *)(out + pos), _mm_add_epi8(s, zero));
+    }
+    return AddScalar(digits1, digits2, out, pos, carry);
+}
+
+/*!
+    SSE4.2実装の引き算（16桁ずつ）
+ */
+__attribute__((target("sse4.2")))
+static int SubSSE42(const char *minuend, const char *subtrahend, char *out, size_t n)
+{
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i zeroes = _mm_setzero_si128();
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i bits = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+    int borrow = 0;
+    size_t pos = n;
+    while (pos >= 16) {
+        pos -= 16;
+        __m128i a = _mm_loadu_si128((const __m128i *)(minuend + pos));
+        __m128i b = _mm_loadu_si128((const __m128i *)(subtrahend + pos));
+        __m128i d = _mm_sub_epi8(a, b);
+        uint64_t generate = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(zeroes, d));
+        uint64_t propagate = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(d, zeroes));
+        uint64_t bmask = ResolveCarries(generate, propagate, 16, borrow);
+
+        __m128i c = _mm_shuffle_epi8(_mm_set1_epi16((short)bmask), spread);
+        c = _mm_cmpeq_epi8(_mm_and_si128(c, bits), bits);
+        d = _mm_add_epi8(d, c);
+        d = _mm_add_epi8(d, _mm_and_si128(_mm_cmpgt_epi8(zeroes, d), ten));
+        _mm_storeu_si128((__m128i *)(out + pos), _mm_add_epi8(d, zero));
+    }
+    return SubScalar(minuend, subtrahend, out, pos, borrow);
+}
+
+/*!
+    AVX2実装の足し算（32桁ずつ）
+ */
+__attribute__((target("avx2")))
+static int AddAVX2(const char *digits1, const char *digits2, char *out, size_t n)
+{
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i spread = _mm256_setr_epi64x(0x0000000000000000LL, 0x0101010101010101LL, 0x0202020202020202LL, 0x0303030303030303LL);
+    const __m256i bits = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    int carry = 0;
+    size_t pos = n;
+    while (pos >= 32) {
+        pos -= 32;
+        __m256i a = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(digits1 + pos)), zero);
+        __m256i b = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(digits2 + pos)), zero);
+        __m256i s = _mm256_add_epi8(a, b);
+        uint64_t generate = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(s, nine));
+        uint64_t propagate = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, nine));
+        uint64_t cmask = ResolveCarries(generate, propagate, 32, carry);
+
+        // マスクのビットをバイトごとの-1/0に展開して足し込む
+        __m256i c = _mm256_shuffle_epi8(_mm256_set1_epi32((int)cmask), spread);
+        c = _mm256_cmpeq_epi8(_mm256_and_si256(c, bits), bits);
+        s = _mm256_sub_epi8(s, c);
+        s = _mm256_sub_epi8(s, _mm256_and_si256(_mm256_cmpgt_epi8(s, nine), ten));
+        _mm256_storeu_si256((__m256i *)(out + pos), _mm256_add_epi8(s, zero));
+    }
+    return AddScalar(digits1, digits2, out, pos, carry);
+}
+
+/*!
+    AVX2実装の引き算（32桁ずつ）
+ */
+__attribute__((target("avx2")))
+static int SubAVX2(const char *minuend, const char *subtrahend, char *out, size_t n)
+{
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i zeroes = _mm256_setzero_si256();
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i spread = _mm256_setr_epi64x(0x0000000000000000LL, 0x0101010101010101LL, 0x0202020202020202LL, 0x0303030303030303LL);
+    const __m256i bits = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    int borrow = 0;
+    size_t pos = n;
+    while (pos >= 32) {
+        pos -= 32;
+        __m256i a = _mm256_loadu_si256((const __m256i *)(minuend + pos));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(subtrahend + pos));
+        __m256i d = _mm256_sub_epi8(a, b);
+        uint64_t generate = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(zeroes, d));
+        uint64_t propagate = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, zeroes));
+        uint64_t bmask = ResolveCarries(generate, propagate, 32, borrow);
+
+        __m256i c = _mm256_shuffle_epi8(_mm256_set1_epi32((int)bmask), spread);
+        c = _mm256_cmpeq_epi8(_mm256_and_si256(c, bits), bits);
+        d = _mm256_add_epi8(d, c);
+        d = _mm256_add_epi8(d, _mm256_and_si256(_mm256_cmpgt_epi8(zeroes, d), ten));
+        _mm256_storeu_si256((__m256i *)(out + pos), _mm256_add_epi8(d, zero));
+    }
+    return SubScalar(minuend, subtrahend, out, pos, borrow);
+}
+
+/*!
+    AVX-512BW実装の足し算（64桁ずつ）
+ */
+__attribute__((target("avx512f,avx512bw")))
+static int AddAVX512(const char *digits1, const char *digits2, char *out, size_t n)
+{
+    const __m512i zero = _mm512_set1_epi8('0');
+    const __m512i nine = _mm512_set1_epi8(9);
+    const __m512i ten = _mm512_set1_epi8(10);
+    const __m512i one = _mm512_set1_epi8(1);
+    int carry = 0;
+    size_t pos = n;
+    while (pos >= 64) {
+        pos -= 64;
+        __m512i a = _mm512_sub_epi8(_mm512_loadu_si512((const void *)(digits1 + pos)), zero);
+        __m512i b = _mm512_sub_epi8(_mm512_loadu_si512((const void *)(digits2 + pos)), zero);
+        __m512i s = _mm512_add_epi8(a, b);
+        uint64_t generate = _mm512_cmpgt_epi8_mask(s, nine);
+        uint64_t propagate = _mm512_cmpeq_epi8_mask(s, nine);
+        __mmask64 cmask = ResolveCarries(generate, propagate, 64, carry);
+        s = _mm512_mask_add_epi8(s, cmask, s, one);
+        s = _mm512_mask_sub_epi8(s, _mm512_cmpgt_epi8_mask(s, nine), s, ten);
+        _mm512_storeu_si512((void *)(out + pos), _mm512_add_epi8(s, zero));
+    }
+    return AddScalar(digits1, digits2, out, pos, carry);
+}
+
+/*!
+    AVX-512BW実装の引き算（64桁ずつ）
+ */
+__attribute__((target("avx512f,avx512bw")))
+static int SubAVX512(const char *minuend, const char *subtrahend, char *out, size_t n)
+{
+    const __m512i zero = _mm512_set1_epi8('0');
+    const __m512i zeroes = _mm512_setzero_si512();
+    const __m512i ten = _mm512_set1_epi8(10);
+    const __m512i one = _mm512_set1_epi8(1);
+    int borrow = 0;
+    size_t pos = n;
+    while (pos >= 64) {
+        pos -= 64;
+        __m512i a = _mm512_loadu_si512((const void *)(minuend + pos));
+        __m512i b = _mm512_loadu_si512((const void *)(subtrahend + pos));
+        __m512i d = _mm512_sub_epi8(a, b);
+        uint64_t generate = _mm512_cmplt_epi8_mask(d, zeroes);
+        uint64_t propagate = _mm512_cmpeq_epi8_mask(d, zeroes);
+        __mmask64 bmask = ResolveCarries(generate, propagate, 64, borrow);
+        d = _mm512_mask_sub_epi8(d, bmask, d, one);
+        d = _mm512_mask_add_epi8(d, _mm512_cmplt_epi8_mask(d, zeroes), d, ten);
+        _mm512_storeu_si512((void *)(out + pos), _mm512_add_epi8(d, zero));
+    }
+    return SubScalar(minuend, subtrahend, out, pos, borrow);
+}
+
+#endif /* INTDIGITS_X86_SIMD */
+
+
+/*!
+    CPUの機能を調べて、使用するカーネルを選択します。
+ */
+static IntDigitsKernel SelectKernel()
+{
+#if INTDIGITS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        return { "avx512bw", AddAVX512, SubAVX512 };
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return { "avx2", AddAVX2, SubAVX2 };
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return { "sse4.2", AddSSE42, SubSSE42 };
+    }
+#endif
+    return { "scalar", AddScalarKernel, SubScalarKernel };
+}
+
+/*!
+    選択済みのカーネルを取得します。初回の呼び出し時に1度だけ選択します。
+ */
+static const IntDigitsKernel& Kernel()
+{
+    static const IntDigitsKernel kernel = SelectKernel();
+    return kernel;
+}
+
+
+// 同じ桁数の数字列同士の足し算
+int IntDigits_Add(const char *digits1, const char *digits2, char *out, size_t n)
+{
+    return Kernel().add(digits1, digits2, out, n);
+}
+
+// 同じ桁数の数字列同士の引き算
+int IntDigits_Sub(const char *minuend, const char *subtrahend, char *out, size_t n)
+{
+    return Kernel().sub(minuend, subtrahend, out, n);
+}
+
+// 数字列に桁上がりを足す
+int IntDigits_AddCarry(const char *digits, char *out, size_t n, int carry)
+{
+    // 桁上がりが止まるまでは9を0にしていき、残りはそのままコピーする
+    size_t pos = n;
+    while (carry > 0 && pos > 0) {
+        pos--;
+        if (digits[pos] == '9') {
+            out[pos] = '0';
+        } else {
+            out[pos] = (char)(digits[pos] + 1);
+            carry = 0;
+        }
+    }
+    if (out != digits) {
+        memcpy(out, digits, pos);
+    }
+    return carry;
+}
+
+// 数字列から借りを引く
+int IntDigits_SubBorrow(const char *digits, char *out, size_t n, int borrow)
+{
+    // 借りが止まるまでは0を9にしていき、残りはそのままコピーする
+    size_t pos = n;
+    while (borrow > 0 && pos > 0) {
+        pos--;
+        if (digits[pos] == '0') {
+            out[pos] = '9';
+        } else {
+            out[pos] = (char)(digits[pos] - 1);
+            borrow = 0;
+        }
+    }
+    if (out != digits) {
+        memcpy(out, digits, pos);
+    }
+    return borrow;
+}
+
+// 選択されたカーネルの名前
+const char *IntDigits_KernelName()
+{
+    return Kernel().name;
+}
@@ -0,0 +1,41 @@
+#ifndef IntDigitsHelper_hpp
+#define IntDigitsHelper_hpp
+
+#include <cstddef>
+
+/*!
+    数字列（'0'〜'9'の文字の配列、上の桁から順に並んだもの）の足し算・引き算を行うカーネル関数群です。
+    実行時にCPUの機能を調べて、AVX-512BW・AVX2・SSE4.2のいずれかのSIMD実装か、スカラー実装を選択します。
+    SIMD実装では、レーンごとの桁上がりの発生・伝播をビットマスクにして、整数の足し算1回で全レーンの桁上がりを求めます（キャリー・ルックアヘッド）。
+ */
+
+/*!
+    同じ桁数の数字列同士の足し算を計算し、n桁の結果をoutに書き込みます。outはdigits1またはdigits2と同じ位置でも構いません。
+    @return 最上位の桁からの桁上がり（0か1）
+ */
+int IntDigits_Add(const char *digits1, const char *digits2, char *out, size_t n);
+
+/*!
+    同じ桁数の数字列同士の引き算を計算し、n桁の結果をoutに書き込みます。outはminuendまたはsubtrahendと同じ位置でも構いません。
+    @return 最上位の桁からの借り（0か1）
+ */
+int IntDigits_Sub(const char *minuend, const char *subtrahend, char *out, size_t n);
+
+/*!
+    数字列に桁上がり（0か1）を足して、n桁の結果をoutに書き込みます。
+    @return 最上位の桁からの桁上がり（0か1）
+ */
+int IntDigits_AddCarry(const char *digits, char *out, size_t n, int carry);
+
+/*!
+    数字列から借り（0か1）を引いて、n桁の結果をoutに書き込みます。
+    @return 最上位の桁からの借り（0か1）
+ */
+int IntDigits_SubBorrow(const char *digits, char *out, size_t n, int borrow);
+
+/*!
+    実行時に選択されたカーネルの名前（"avx512bw", "avx2", "sse4.2", "scalar"のいずれか）を取得します。
+ */
+const char *IntDigits_KernelName();
+
+#endif /* IntDigitsHelper_hpp */
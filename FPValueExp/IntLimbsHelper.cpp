@@ -0,0 +1,769 @@
+#include "IntLimbsHelper.hpp"
+#include "FPComputeContext.hpp"
+#include "FPTuning.hpp"
+#include "IntStringHelper.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INTLIMBS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+/*! 筆算の掛け算のカーネル関数 */
+typedef void (*MultSchoolFunc)(const IntLimbs& limbs1, const IntLimbs& limbs2, IntLimbs& ret);
+
+/*! 10^9（1つのリムに収まる最大の10の累乗） */
+static const uint32_t kChunkBase = 1000000000;
+
+/*! Lehmer法で使う上位ビットの近似値のビット数（余因子の計算がint64_tであふれないようにする） */
+static const int kLehmerBits = 60;
+
+
+// 上位の不要な0を取り除く
+void IntLimbs_Normalize(IntLimbs& limbs)
+{
+    while (limbs.size() > 0 && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
+
+// 大小比較
+int IntLimbs_Compare(const IntLimbs& limbs1, const IntLimbs& limbs2)
+{
+    if (limbs1.size() != limbs2.size()) {
+        return (limbs1.size() > limbs2.size())? 1: -1;
+    }
+    for (size_t i = limbs1.size(); i > 0; i--) {
+        if (limbs1[i-1] != limbs2[i-1]) {
+            return (limbs1[i-1] > limbs2[i-1])? 1: -1;
+        }
+    }
+    return 0;
+}
+
+/*!
+    accにxを(shift)リム分ずらして加算します。
+ */
+static void AddShifted(IntLimbs& acc, const IntLimbs& x, size_t shift)
+{
+    if (x.size() == 0) {
+        return;
+    }
+    if (acc.size() < x.size() + shift) {
+        acc.resize(x.size() + shift, 0);
+    }
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < x.size(); i++) {
+        uint64_t t = (uint64_t)acc[i+shift] + x[i] + carry;
+        acc[i+shift] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    for (size_t j = i + shift; carry > 0; j++) {
+        if (j == acc.size()) {
+            acc.push_back(0);
+        }
+        uint64_t t = (uint64_t)acc[j] + carry;
+        acc[j] = (uint32_t)t;
+        carry = t >> 32;
+    }
+}
+
+/*!
+    accからxを引き算します。acc >= x である必要があります。
+ */
+static void SubInPlace(IntLimbs& acc, const IntLimbs& x)
+{
+    int64_t borrow = 0;
+    size_t i = 0;
+    for (; i < x.size(); i++) {
+        int64_t t = (int64_t)acc[i] - x[i] - borrow;
+        borrow = (t < 0)? 1: 0;
+        acc[i] = (uint32_t)t;
+    }
+    for (; borrow > 0 && i < acc.size(); i++) {
+        int64_t t = (int64_t)acc[i] - borrow;
+        borrow = (t < 0)? 1: 0;
+        acc[i] = (uint32_t)t;
+    }
+    IntLimbs_Normalize(acc);
+}
+
+/*!
+    リム配列の[begin, begin+len)の範囲を取り出して正規化します。
+ */
+static IntLimbs Slice(const IntLimbs& limbs, size_t begin, size_t len)
+{
+    if (begin >= limbs.size()) {
+        return IntLimbs();
+    }
+    size_t end = (len < limbs.size() - begin)? (begin + len): limbs.size();
+    IntLimbs ret(limbs.begin() + begin, limbs.begin() + end);
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    筆算による掛け算を計算します（スカラー実装）。
+ */
+static void MultSchoolScalar(const IntLimbs& limbs1, const IntLimbs& limbs2, IntLimbs& ret)
+{
+    for (size_t i = 0; i < limbs1.size(); i++) {
+        uint64_t a = limbs1[i];
+        uint64_t carry = 0;
+        for (size_t j = 0; j < limbs2.size(); j++) {
+            uint64_t t = a * limbs2[j] + ret[i+j] + carry;
+            ret[i+j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        ret[i + limbs2.size()] = (uint32_t)carry;
+    }
+}
+
+#if INTLIMBS_X86_SIMD
+
+/*!
+    リム配列を64ビットに拡張し、前後にpad個ずつ0を詰めた配列を作成します。
+ */
+static std::vector<uint64_t> PadLimbs(const IntLimbs& limbs, size_t pad)
+{
+    std::vector<uint64_t> ret(limbs.size() + pad * 2, 0);
+    for (size_t i = 0; i < limbs.size(); i++) {
+        ret[i + pad] = limbs[i];
+    }
+    return ret;
+}
+
+/*!
+    列k〜k+W-1の積の下位32ビットの和loと上位32ビットの和hiを、桁上がりを処理しながら結果のリムに書き込みます。
+    各列の値は lo + hi * 2^32 で、hiの部分は次の列に繰り越します。最上位のリムは呼び出し側で書き込みます。
+ */
+static void StoreColumns(const uint64_t *lo, const uint64_t *hi, size_t W, size_t k, IntLimbs& ret, uint64_t& carry, uint64_t& prevHi)
+{
+    size_t end = std::min(k + W, ret.size() - 1);
+    for (size_t c = k; c < end; c++) {
+        uint64_t t = lo[c - k] + prevHi + carry;
+        ret[c] = (uint32_t)t;
+        carry = t >> 32;
+        prevHi = hi[c - k];
+    }
+}
+
+/*!
+    筆算による掛け算を計算します（AVX2実装）。
+    結果の4列分の積を32x32→64ビットの掛け算（vpmuludq）でまとめて求め、下位・上位32ビットに分けてレジスタ上で足し込みます。
+    桁上がりの処理は4列ごとにまとめて行います。limbs1の方が長いことを前提とします。
+ */
+__attribute__((target("avx2")))
+static void MultSchoolAVX2(const IntLimbs& limbs1, const IntLimbs& limbs2, IntLimbs& ret)
+{
+    static const size_t W = 4;
+    size_t n1 = limbs1.size();
+    size_t n2 = limbs2.size();
+    std::vector<uint64_t> b = PadLimbs(limbs2, W);
+    size_t columns = n1 + n2 - 1;
+    uint64_t lo[W], hi[W];
+    uint64_t carry = 0;
+    uint64_t prevHi = 0;
+    const __m256i mask = _mm256_set1_epi64x(0xffffffffLL);
+    for (size_t k = 0; k < columns; k += W) {
+        // 列k〜k+W-1に寄与するlimbs1の範囲
+        size_t iBegin = (k + 1 > n2)? (k + 1 - n2): 0;
+        size_t iEnd = std::min(n1, k + W);
+        __m256i sumLo = _mm256_setzero_si256();
+        __m256i sumHi = _mm256_setzero_si256();
+        for (size_t i = iBegin; i < iEnd; i++) {
+            __m256i va = _mm256_set1_epi64x((long long)limbs1[i]);
+            __m256i vb = _mm256_loadu_si256((const __m256i *)&b[k + W - i]);
+            __m256i prod = _mm256_mul_epu32(va, vb);
+            sumLo = _mm256_add_epi64(sumLo, _mm256_and_si256(prod, mask));
+            sumHi = _mm256_add_epi64(sumHi, _mm256_srli_epi64(prod, 32));
+        }
+        _mm256_storeu_si256((__m256i *)lo, sumLo);
+        _mm256_storeu_si256((__m256i *)hi, sumHi);
+        StoreColumns(lo, hi, W, k, ret, carry, prevHi);
+    }
+    ret[columns] = (uint32_t)(prevHi + carry);
+}
+
+#endif /* INTLIMBS_X86_SIMD */
+
+/*!
+    CPUの機能を調べて、筆算の掛け算に使用するカーネルを選択します。
+ */
+static MultSchoolFunc SelectMultSchool()
+{
+#if INTLIMBS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return MultSchoolAVX2;
+    }
+#endif
+    return MultSchoolScalar;
+}
+
+/*!
+    筆算による掛け算を計算します。短い方がプロファイルで指定されたリム数以上ある場合は、実行時に選択したSIMD実装を使います。
+ */
+static IntLimbs MultSchool(const IntLimbs& limbs1, const IntLimbs& limbs2)
+{
+    static const MultSchoolFunc simdMult = SelectMultSchool();
+    const IntLimbs& a = (limbs1.size() >= limbs2.size())? limbs1: limbs2;
+    const IntLimbs& b = (limbs1.size() >= limbs2.size())? limbs2: limbs1;
+    IntLimbs ret(a.size() + b.size(), 0);
+    if ((int)b.size() >= FPTuning::Current().simdMultMinLimbs) {
+        simdMult(a, b, ret);
+    } else {
+        MultSchoolScalar(a, b, ret);
+    }
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    リム配列に1リムの数を掛けて、1リムの数を足します（その場で計算）。
+ */
+static void MultAddSmall(IntLimbs& limbs, uint32_t mul, uint32_t add)
+{
+    uint64_t carry = add;
+    for (size_t i = 0; i < limbs.size(); i++) {
+        uint64_t t = (uint64_t)limbs[i] * mul + carry;
+        limbs[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    if (carry > 0) {
+        limbs.push_back((uint32_t)carry);
+    }
+}
+
+/*!
+    リム配列を1リムの数で割り、余りをリターンします（その場で計算）。
+ */
+static uint32_t DivSmall(IntLimbs& limbs, uint32_t divisor)
+{
+    uint64_t rem = 0;
+    for (size_t i = limbs.size(); i > 0; i--) {
+        uint64_t t = (rem << 32) | limbs[i-1];
+        limbs[i-1] = (uint32_t)(t / divisor);
+        rem = t % divisor;
+    }
+    IntLimbs_Normalize(limbs);
+    return (uint32_t)rem;
+}
+
+// 足し算
+IntLimbs IntLimbs_Add(const IntLimbs& limbs1, const IntLimbs& limbs2)
+{
+    IntLimbs ret(limbs1);
+    AddShifted(ret, limbs2, 0);
+    return ret;
+}
+
+// 引き算
+IntLimbs IntLimbs_Sub(const IntLimbs& minuend, const IntLimbs& subtrahend)
+{
+    IntLimbs ret(minuend);
+    SubInPlace(ret, subtrahend);
+    return ret;
+}
+
+// 掛け算
+IntLimbs IntLimbs_Mult(const IntLimbs& limbs1, const IntLimbs& limbs2)
+{
+    const IntLimbs& a = (limbs1.size() >= limbs2.size())? limbs1: limbs2;
+    const IntLimbs& b = (limbs1.size() >= limbs2.size())? limbs2: limbs1;
+    if (b.size() == 0) {
+        return IntLimbs();
+    }
+    if ((int)b.size() < FPTuning::Current().karatsubaLimbs) {
+        return MultSchool(a, b);
+    }
+
+    // 大きさが極端に違う場合は、大きい方をbの長さごとに区切って計算する
+    size_t half = (a.size() + 1) / 2;
+    if (b.size() <= half) {
+        IntLimbs ret;
+        for (size_t pos = 0; pos < a.size(); pos += b.size()) {
+            AddShifted(ret, IntLimbs_Mult(Slice(a, pos, b.size()), b), pos);
+        }
+        return ret;
+    }
+
+    // Karatsuba法: (a1*B^h + a0)(b1*B^h + b0) = z2*B^2h + z1*B^h + z0
+    FPComputeContext::CheckPoint();
+    IntLimbs a0 = Slice(a, 0, half);
+    IntLimbs a1 = Slice(a, half, a.size());
+    IntLimbs b0 = Slice(b, 0, half);
+    IntLimbs b1 = Slice(b, half, b.size());
+    IntLimbs z0 = IntLimbs_Mult(a0, b0);
+    IntLimbs z2 = IntLimbs_Mult(a1, b1);
+    IntLimbs z1 = IntLimbs_Mult(IntLimbs_Add(a0, a1), IntLimbs_Add(b0, b1));
+    SubInPlace(z1, z0);
+    SubInPlace(z1, z2);
+
+    IntLimbs ret(z0);
+    AddShifted(ret, z1, half);
+    AddShifted(ret, z2, half * 2);
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    64ビットの数をリム配列に変換します。
+ */
+static IntLimbs FromUint64(uint64_t value)
+{
+    IntLimbs ret;
+    ret.push_back((uint32_t)value);
+    ret.push_back((uint32_t)(value >> 32));
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    64ビット以下のリム配列を64ビットの数に変換します。
+ */
+static uint64_t ToUint64(const IntLimbs& limbs)
+{
+    uint64_t ret = 0;
+    for (size_t i = limbs.size(); i > 0; i--) {
+        ret = (ret << 32) | limbs[i-1];
+    }
+    return ret;
+}
+
+/*!
+    リム配列を左にbitsビット（0〜31）ずらした配列を作成します。最上位に1リム余分に確保します。
+ */
+static IntLimbs ShiftLeftBits(const IntLimbs& limbs, int bits)
+{
+    IntLimbs ret(limbs.size() + 1, 0);
+    for (size_t i = 0; i < limbs.size(); i++) {
+        uint64_t t = (uint64_t)limbs[i] << bits;
+        ret[i] |= (uint32_t)t;
+        ret[i+1] = (uint32_t)(t >> 32);
+    }
+    return ret;
+}
+
+/*!
+    リム配列の先頭n個を右にbitsビット（0〜31）ずらして正規化した配列を作成します。
+ */
+static IntLimbs ShiftRightBits(const IntLimbs& limbs, size_t n, int bits)
+{
+    IntLimbs ret(n, 0);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = limbs[i];
+        if (i + 1 < limbs.size()) {
+            t |= (uint64_t)limbs[i+1] << 32;
+        }
+        ret[i] = (uint32_t)(t >> bits);
+    }
+    IntLimbs_Normalize(ret);
+    return ret;
+}
+
+/*!
+    リム配列のbitビット目から上の64ビットを取り出します。
+ */
+static uint64_t ExtractBits(const IntLimbs& limbs, size_t bit)
+{
+    size_t w = bit / 32;
+    int s = (int)(bit % 32);
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    if (w < limbs.size()) {
+        lo = limbs[w];
+    }
+    if (w + 1 < limbs.size()) {
+        lo |= (uint64_t)limbs[w+1] << 32;
+    }
+    if (w + 2 < limbs.size()) {
+        hi = limbs[w+2];
+    }
+    return (s == 0)? lo: ((lo >> s) | (hi << (64 - s)));
+}
+
+/*!
+    リム配列のビット長を計算します。
+ */
+static size_t BitLength(const IntLimbs& limbs)
+{
+    if (limbs.size() == 0) {
+        return 0;
+    }
+    return (limbs.size() - 1) * 32 + (32 - __builtin_clz(limbs.back()));
+}
+
+/*!
+    x*a + y*b を計算します。xとyは異符号（どちらかが0でも構いません）で、結果は0以上である必要があります。
+ */
+static IntLimbs LinearCombine(const IntLimbs& a, int64_t x, const IntLimbs& b, int64_t y)
+{
+    if (y <= 0) {
+        IntLimbs ret = IntLimbs_Mult(a, FromUint64((uint64_t)x));
+        SubInPlace(ret, IntLimbs_Mult(b, FromUint64((uint64_t)-y)));
+        return ret;
+    } else {
+        IntLimbs ret = IntLimbs_Mult(b, FromUint64((uint64_t)y));
+        SubInPlace(ret, IntLimbs_Mult(a, FromUint64((uint64_t)-x)));
+        return ret;
+    }
+}
+
+// 割り算
+std::pair<IntLimbs, IntLimbs> IntLimbs_DivMod(const IntLimbs& dividend, const IntLimbs& divisor)
+{
+    if (divisor.size() == 0) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+    if (IntLimbs_Compare(dividend, divisor) < 0) {
+        return std::make_pair(IntLimbs(), dividend);
+    }
+    if (divisor.size() == 1) {
+        IntLimbs q(dividend);
+        uint32_t r = DivSmall(q, divisor[0]);
+        return std::make_pair(q, (r > 0)? IntLimbs(1, r): IntLimbs());
+    }
+
+    // 割る数と商がどちらも長い場合は、ニュートン法で求めた逆数を掛けて計算する
+    size_t newtonMinLimbs = (size_t)FPTuning::Current().divNewtonMinLimbs;
+    if (divisor.size() >= newtonMinLimbs && dividend.size() - divisor.size() + 1 >= newtonMinLimbs) {
+        size_t k = std::max(dividend.size(), divisor.size() * 2);
+        return IntLimbs_DivModReciprocal(dividend, divisor, IntLimbs_Reciprocal(divisor, k), k);
+    }
+
+    // 割る数の最上位ビットが立つように、両方を同じだけ左にずらす
+    int bits = __builtin_clz(divisor.back());
+    IntLimbs v = ShiftLeftBits(divisor, bits);
+    v.pop_back();
+    IntLimbs u = ShiftLeftBits(dividend, bits);
+    size_t n = v.size();
+    size_t m = dividend.size() - n;
+    IntLimbs q(m + 1, 0);
+    for (size_t j = m + 1; j > 0; j--) {
+        size_t k = j - 1;
+        FPComputeContext::CheckPoint();
+
+        // 上位2リムから商の1リムを見積もる（真の値より最大2大きい）
+        uint64_t top = ((uint64_t)u[k+n] << 32) | u[k+n-1];
+        uint64_t qhat = top / v[n-1];
+        uint64_t rhat = top % v[n-1];
+        while (qhat > UINT32_MAX || qhat * v[n-2] > ((rhat << 32) | u[k+n-2])) {
+            qhat--;
+            rhat += v[n-1];
+            if (rhat > UINT32_MAX) {
+                break;
+            }
+        }
+
+        // qhat × 割る数を引く
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t p = qhat * v[i];
+            int64_t t = (int64_t)u[i+k] - borrow - (int64_t)(p & UINT32_MAX);
+            u[i+k] = (uint32_t)t;
+            borrow = (int64_t)(p >> 32) - (t >> 32);
+        }
+        int64_t t = (int64_t)u[k+n] - borrow;
+        u[k+n] = (uint32_t)t;
+
+        // 引きすぎた場合は1回分足し戻す
+        if (t < 0) {
+            qhat--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t s = (uint64_t)u[i+k] + v[i] + carry;
+                u[i+k] = (uint32_t)s;
+                carry = s >> 32;
+            }
+            u[k+n] += (uint32_t)carry;
+        }
+        q[k] = (uint32_t)qhat;
+    }
+    IntLimbs_Normalize(q);
+    return std::make_pair(q, ShiftRightBits(u, n, bits));
+}
+
+// 最大公約数
+IntLimbs IntLimbs_GCD(const IntLimbs& limbs1, const IntLimbs& limbs2)
+{
+    IntLimbs a = (IntLimbs_Compare(limbs1, limbs2) >= 0)? limbs1: limbs2;
+    IntLimbs b = (IntLimbs_Compare(limbs1, limbs2) >= 0)? limbs2: limbs1;
+    while (b.size() > 2) {
+        FPComputeContext::CheckPoint();
+
+        // aとbの上位ビットを同じだけずらした近似値で、互除法を進められるところまで進める
+        size_t shift = BitLength(a) - kLehmerBits;
+        int64_t ahat = (int64_t)ExtractBits(a, shift);
+        int64_t bhat = (int64_t)ExtractBits(b, shift);
+        int64_t A = 1, B = 0, C = 0, D = 1;
+        while (bhat + C != 0 && bhat + D != 0) {
+            int64_t q = (ahat + A) / (bhat + C);
+            if (q != (ahat + B) / (bhat + D)) {
+                break;
+            }
+            int64_t t = A - q * C;
+            A = C;
+            C = t;
+            t = B - q * D;
+            B = D;
+            D = t;
+            t = ahat - q * bhat;
+            ahat = bhat;
+            bhat = t;
+        }
+
+        // 1回も進められなかった場合は、通常の互除法を1回行う
+        if (B == 0) {
+            IntLimbs r = IntLimbs_DivMod(a, b).second;
+            a.swap(b);
+            b.swap(r);
+            continue;
+        }
+        IntLimbs na = LinearCombine(a, A, b, B);
+        IntLimbs nb = LinearCombine(a, C, b, D);
+        a.swap(na);
+        b.swap(nb);
+    }
+
+    // 64ビットに収まったら通常の互除法で計算する
+    if (b.size() == 0) {
+        return a;
+    }
+    uint64_t y = ToUint64(b);
+    uint64_t x = (a.size() > 2)? ToUint64(IntLimbs_DivMod(a, b).second): ToUint64(a);
+    while (y != 0) {
+        uint64_t t = x % y;
+        x = y;
+        y = t;
+    }
+    return FromUint64(x);
+}
+
+/*! 10の(2^k)乗と、そのBarrett法のための逆数のキャッシュ */
+static std::mutex sPowerMutex;
+static std::deque<IntLimbs> sPowers;
+static std::deque<IntLimbs> sPowerInverses;
+
+// 10の(2^k)乗
+const IntLimbs& IntLimbs_PowerOfTen(int k)
+{
+    std::lock_guard<std::mutex> lock(sPowerMutex);
+    if (sPowers.size() == 0) {
+        sPowers.push_back(IntLimbs(1, 10));
+    }
+    while ((int)sPowers.size() <= k) {
+        const IntLimbs& last = sPowers.back();
+        sPowers.push_back(IntLimbs_Mult(last, last));
+    }
+    return sPowers[k];
+}
+
+/*!
+    floor(B^(2s) / divisor)（sはdivisorのリム数、B=2^32）をニュートン法で計算します。
+    上位の約半分のリムの逆数を再帰的に求めて初期値とするので、精度が倍々に上がっていきます。
+ */
+static IntLimbs ComputeInverse(const IntLimbs& divisor)
+{
+    size_t s = divisor.size();
+    IntLimbs x;
+    if (s <= 4) {
+        // 初期値: B^(s+1) / (最上位のリム + 1)
+        uint64_t seed = UINT64_MAX / ((uint64_t)divisor.back() + 1);
+        x.assign(s - 1, 0);
+        x.push_back((uint32_t)seed);
+        x.push_back((uint32_t)(seed >> 32));
+        IntLimbs_Normalize(x);
+    } else {
+        // 初期値: 上位hリムの逆数を(s-h)リム分ずらしたもの
+        size_t h = (s + 1) / 2 + 1;
+        IntLimbs xh = ComputeInverse(Slice(divisor, s - h, h));
+        x.assign(s - h, 0);
+        x.insert(x.end(), xh.begin(), xh.end());
+    }
+
+    // x <- x + x * (B^(2s) - divisor * x) / B^(2s) を、余りがdivisor未満になるまで繰り返す
+    IntLimbs bs(2 * s + 1, 0);
+    bs[2 * s] = 1;
+    while (true) {
+        IntLimbs dx = IntLimbs_Mult(divisor, x);
+        if (IntLimbs_Compare(dx, bs) > 0) {
+            // 真の値より大きい場合は、切り上げて引くことで真の値以下にする
+            IntLimbs dec = Slice(IntLimbs_Mult(x, IntLimbs_Sub(dx, bs)), 2 * s, SIZE_MAX);
+            AddShifted(dec, IntLimbs(1, 1), 0);
+            SubInPlace(x, dec);
+            continue;
+        }
+        IntLimbs e = IntLimbs_Sub(bs, dx);
+        if (IntLimbs_Compare(e, divisor) < 0) {
+            break;
+        }
+        IntLimbs inc = Slice(IntLimbs_Mult(x, e), 2 * s, SIZE_MAX);
+        if (inc.size() == 0) {
+            inc.push_back(1);
+        }
+        AddShifted(x, inc, 0);
+    }
+    return x;
+}
+
+/*!
+    10の(2^k)乗の逆数（Barrett法のための値）を取得します。
+ */
+static const IntLimbs& PowerOfTenInverse(int k)
+{
+    const IntLimbs& power = IntLimbs_PowerOfTen(k);
+    std::lock_guard<std::mutex> lock(sPowerMutex);
+    while ((int)sPowerInverses.size() <= k) {
+        sPowerInverses.push_back(IntLimbs());
+    }
+    if (sPowerInverses[k].size() == 0) {
+        sPowerInverses[k] = ComputeInverse(power);
+    }
+    return sPowerInverses[k];
+}
+
+// 割り算のための逆数
+IntLimbs IntLimbs_Reciprocal(const IntLimbs& divisor, size_t k)
+{
+    if (divisor.size() == 0) {
+        throw std::runtime_error("Zero division is now allowed.");
+    }
+
+    // floor(B^(2(s+t)) / (divisor * B^t)) = floor(B^(2s+t) / divisor) なので、divisorをtリムずらして逆数を求める
+    size_t t = k - 2 * divisor.size();
+    IntLimbs shifted(t, 0);
+    shifted.insert(shifted.end(), divisor.begin(), divisor.end());
+    return ComputeInverse(shifted);
+}
+
+// 逆数を使った割り算
+std::pair<IntLimbs, IntLimbs> IntLimbs_DivModReciprocal(const IntLimbs& value, const IntLimbs& divisor, const IntLimbs& inverse, size_t k)
+{
+    IntLimbs q = Slice(IntLimbs_Mult(value, inverse), k, SIZE_MAX);
+    IntLimbs r = IntLimbs_Sub(value, IntLimbs_Mult(q, divisor));
+    while (IntLimbs_Compare(r, divisor) >= 0) {
+        SubInPlace(r, divisor);
+        AddShifted(q, IntLimbs(1, 1), 0);
+    }
+    return std::make_pair(q, r);
+}
+
+/*!
+    Barrett法で割り算を計算します。value < divisor^2 である必要があります。
+    @return 商をfirst, 余りをsecondにしたペア
+ */
+static std::pair<IntLimbs, IntLimbs> DivModBarrett(const IntLimbs& value, const IntLimbs& divisor, const IntLimbs& inverse)
+{
+    size_t s = divisor.size();
+    IntLimbs q = Slice(IntLimbs_Mult(Slice(value, s - 1, SIZE_MAX), inverse), s + 1, SIZE_MAX);
+    IntLimbs r = IntLimbs_Sub(value, IntLimbs_Mult(q, divisor));
+    while (IntLimbs_Compare(r, divisor) >= 0) {
+        SubInPlace(r, divisor);
+        AddShifted(q, IntLimbs(1, 1), 0);
+    }
+    return std::make_pair(q, r);
+}
+
+/*!
+    整数文字列の[str, str+len)の範囲をリム配列に変換します。
+ */
+static IntLimbs ToLimbsRec(const char *str, int len)
+{
+    FPComputeContext::CheckPoint();
+    // 短い場合は9桁ずつ読み込む
+    if (len <= FPTuning::Current().convBaseDigits) {
+        IntLimbs ret;
+        int pos = 0;
+        while (pos < len) {
+            int chunkLen = std::min(9, len - pos);
+            uint32_t chunk = 0;
+            uint32_t mul = 1;
+            for (int i = 0; i < chunkLen; i++) {
+                chunk = chunk * 10 + (uint32_t)(str[pos+i] - '0');
+                mul *= 10;
+            }
+            MultAddSmall(ret, mul, chunk);
+            pos += chunkLen;
+        }
+        IntLimbs_Normalize(ret);
+        return ret;
+    }
+
+    // 下位の2^k桁と、それより上の桁に分けて変換する
+    int k = 0;
+    while ((2 << k) < len) {
+        k++;
+    }
+    int lowLen = 1 << k;
+    IntLimbs high = ToLimbsRec(str, len - lowLen);
+    IntLimbs low = ToLimbsRec(str + (len - lowLen), lowLen);
+    IntLimbs ret = IntLimbs_Mult(high, IntLimbs_PowerOfTen(k));
+    AddShifted(ret, low, 0);
+    return ret;
+}
+
+/*!
+    10の(2^(k+1))乗より小さい数を文字列に変換して、outの末尾に追加します。
+    widthが0より大きい場合は、ちょうどwidth桁になるように上位を0で埋めます。
+ */
+static void FromLimbsRec(const IntLimbs& value, int k, int width, std::string& out)
+{
+    FPComputeContext::CheckPoint();
+    // 短い場合は10^9で割りながら変換する
+    if ((2 << k) <= FPTuning::Current().convBaseDigits) {
+        IntLimbs v(value);
+        std::string digits;
+        while (v.size() > 0) {
+            uint32_t chunk = DivSmall(v, kChunkBase);
+            for (int i = 0; i < 9; i++) {
+                digits += (char)('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+        while (digits.size() > 0 && digits.back() == '0') {
+            digits.pop_back();
+        }
+        if ((int)digits.size() < width) {
+            digits.append(width - digits.size(), '0');
+        }
+        out.append(digits.rbegin(), digits.rend());
+        return;
+    }
+
+    // 10の(2^k)乗で割って、上位と下位を別々に変換する
+    std::pair<IntLimbs, IntLimbs> qr = DivModBarrett(value, IntLimbs_PowerOfTen(k), PowerOfTenInverse(k));
+    int lowLen = 1 << k;
+    FromLimbsRec(qr.first, k - 1, (width > 0)? (width - lowLen): 0, out);
+    FromLimbsRec(qr.second, k - 1, lowLen, out);
+}
+
+// 整数文字列からリム配列への変換
+IntLimbs IntString_ToLimbs(const std::string& istr_n)
+{
+    return ToLimbsRec(istr_n.c_str(), (int)istr_n.length());
+}
+
+// リム配列から整数文字列への変換
+std::string IntString_FromLimbs(const IntLimbs& limbs)
+{
+    if (limbs.size() == 0) {
+        return "0";
+    }
+
+    // value < 10^(2^(k+1)) となるkを探す
+    int k = 0;
+    while (IntLimbs_Compare(IntLimbs_PowerOfTen(k + 1), limbs) <= 0) {
+        k++;
+    }
+
+    std::string ret;
+    FromLimbsRec(limbs, k, 0, ret);
+    return IntString_Normalize(ret);
+}
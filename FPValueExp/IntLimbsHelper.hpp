@@ -0,0 +1,85 @@
+#ifndef IntLimbsHelper_hpp
+#define IntLimbsHelper_hpp
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+    正の整数を2^32進数で表したリム（limb）の配列です。
+    下位のリムから順に格納し、最上位のリムは0以外になるように正規化します（0は空の配列）。
+ */
+typedef std::vector<uint32_t> IntLimbs;
+
+/*!
+    リム配列の上位にある不要な0を取り除きます。
+ */
+void IntLimbs_Normalize(IntLimbs& limbs);
+
+/*!
+    正規化されたリム配列同士の大小比較を行います。
+    @return limbs1がlimbs2よりも大きければ1、小さければ-1、等しければ0
+ */
+int IntLimbs_Compare(const IntLimbs& limbs1, const IntLimbs& limbs2);
+
+/*!
+    正規化されたリム配列同士で、足し算を計算します。
+ */
+IntLimbs IntLimbs_Add(const IntLimbs& limbs1, const IntLimbs& limbs2);
+
+/*!
+    正規化されたリム配列同士で、引き算を計算します。minuend >= subtrahend である必要があります。
+ */
+IntLimbs IntLimbs_Sub(const IntLimbs& minuend, const IntLimbs& subtrahend);
+
+/*!
+    正規化されたリム配列同士で、掛け算を計算します。
+    小さな数は筆算で、大きな数はKaratsuba法で計算します。
+ */
+IntLimbs IntLimbs_Mult(const IntLimbs& limbs1, const IntLimbs& limbs2);
+
+/*!
+    正規化されたリム配列同士で、割り算を計算します（KnuthのアルゴリズムD）。divisorが0の場合は例外を投げます。
+    割る数と商がどちらもプロファイル（FPTuning）で指定されたリム数以上ある場合は、ニュートン法で求めた逆数を使って計算します。
+    @return 商をfirst, 余りをsecondにしたペア
+ */
+std::pair<IntLimbs, IntLimbs> IntLimbs_DivMod(const IntLimbs& dividend, const IntLimbs& divisor);
+
+/*!
+    割り算を掛け算で行うための逆数 floor(B^k / divisor)（B=2^32）を計算します。kはdivisorのリム数の2倍以上である必要があります。
+ */
+IntLimbs IntLimbs_Reciprocal(const IntLimbs& divisor, size_t k);
+
+/*!
+    IntLimbs_Reciprocal()で求めた逆数を使って、Barrett法で割り算を計算します。
+    商の見積もりに掛け算を1回、余りの計算に掛け算を1回使い、最後に高々2回の補正を行います。value < B^k である必要があります。
+    @return 商をfirst, 余りをsecondにしたペア
+ */
+std::pair<IntLimbs, IntLimbs> IntLimbs_DivModReciprocal(const IntLimbs& value, const IntLimbs& divisor, const IntLimbs& inverse, size_t k);
+
+/*!
+    正規化されたリム配列同士の最大公約数を計算します。
+    上位64ビット弱の近似値でユークリッドの互除法を進めて複数の商をまとめて適用するLehmer法を使い、
+    どちらかが64ビットに収まった後は通常の互除法で計算します。
+ */
+IntLimbs IntLimbs_GCD(const IntLimbs& limbs1, const IntLimbs& limbs2);
+
+/*!
+    10の(2^k)乗を表すリム配列を取得します。一度計算した値はキャッシュされます。
+ */
+const IntLimbs& IntLimbs_PowerOfTen(int k);
+
+/*!
+    正規化された整数文字列を、リム配列に変換します。
+    キャッシュした10の(2^k)乗を使った分割統治法により、M(n)・log n の計算量で変換します。
+ */
+IntLimbs IntString_ToLimbs(const std::string& istr_n);
+
+/*!
+    リム配列を、正規化された整数文字列に変換します。
+    キャッシュした10の(2^k)乗とその逆数を使った分割統治法により、M(n)・log n の計算量で変換します。
+ */
+std::string IntString_FromLimbs(const IntLimbs& limbs);
+
+#endif /* IntLimbsHelper_hpp */
@@ -1,5 +1,14 @@
 #include "IntStringHelper.hpp"
-#include <vector>
+#include "FPComputeContext.hpp"
+#include "FPTuning.hpp"
+#include "IntDigitsHelper.hpp"
+#include "IntLimbsHelper.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+/*! リム配列に変換せずに掛け算を計算する場合の、短い方の数の最大の桁数（1つのintで掛けてもあふれない桁数） */
+static const int kShortMultMaxDigits = 8;
 
 
 // 正の整数を表す文字列を、不要なゼロが付いていない形式に正規化する。
@@ -8,11 +17,11 @@ std::string IntString_Normalize(const std::string& istr)
     if (istr.length() == 0) {
         return "0";
     }
-    std::string ret = istr;
-    while (ret.length() > 1 && ret[0] == '0') {
-        ret = ret.substr(1);
+    size_t pos = istr.find_first_not_of('0');
+    if (pos == std::string::npos) {
+        return "0";
     }
-    return ret;
+    return (pos == 0)? istr: istr.substr(pos);
 }
 
 // 正の整数を表す文字列（正規化済み）の大小比較
@@ -40,35 +49,19 @@ int IntString_Compare(const std::string& istr_n_1, const std::string& istr_n_2)
 // 正の整数を表す文字列同士で、足し算を計算する。
 std::string IntString_Add(const std::string& istr_n_1, const std::string& istr_n_2)
 {
-    // 桁数を合わせる
-    std::string str1 = istr_n_1;
-    std::string str2 = istr_n_2;
-    int len1 = (int)str1.length();
-    int len2 = (int)str2.length();
-    while (len1 < len2) {
-        str1 = "0" + str1;
-        len1++;
-    }
-    while (len2 < len1) {
-        str2 = "0" + str2;
-        len2++;
-    }
-
-    // 足し算を計算する
-    std::string result = "";
-    int overflow = 0;
-    for (int i = 0; i < len1; i++) {
-        int v1 = str1[len1-i-1] - '0';
-        int v2 = str2[len1-i-1] - '0';
-        int v3 = v1 + v2 + overflow;
-        //printf("  %d + %d (+ %d) => %d\n", v1, v2, overflow, v3);
-        overflow = v3 / 10;
-        //printf("    overflow = %d\n", overflow);
-        result = (char)((v3 % 10) + '0') + result;
-        //printf("    result = [%s]\n", result.c_str());
-    }
-    if (overflow > 0) {
-        result = (char)(overflow + '0') + result;
+    // 長い方をlonger、短い方をshorterとする
+    const std::string& longer = (istr_n_1.length() >= istr_n_2.length())? istr_n_1: istr_n_2;
+    const std::string& shorter = (istr_n_1.length() >= istr_n_2.length())? istr_n_2: istr_n_1;
+    size_t len = longer.length();
+    size_t diff = len - shorter.length();
+
+    // 桁の重なる部分をカーネルで足し、残りの上の桁に桁上がりを伝播させる
+    std::string result(len + 1, '0');
+    int carry = IntDigits_Add(longer.data() + diff, shorter.data(), &result[1 + diff], shorter.length());
+    carry = IntDigits_AddCarry(longer.data(), &result[1], diff, carry);
+    if (carry > 0) {
+        result[0] = '1';
+        return result;
     }
 
     // 正規化した値をリターンする
@@ -84,32 +77,12 @@ std::string IntString_Sub(const std::string& minuend_istr_n, const std::string&
         return "0";
     }
 
-    // 桁数を合わせる
-    std::string subtrahend_istr = subtrahend_istr_n;
-    int len = (int)minuend_istr_n.length();
-    int len_diff = len - (int)subtrahend_istr_n.length();
-    for (int i = 0; i < len_diff; i++) {
-        subtrahend_istr = "0" + subtrahend_istr;
-    }
-
-    // 引き算を計算する
-    std::string result = "";
-    bool underflow = false;
-    for (int i = 0; i < len; i++) {
-        int v1 = (int)(minuend_istr_n[len-i-1] - '0');
-        int v2 = (int)(subtrahend_istr[len-i-1] - '0');
-        //printf("  %d - %d (underflow=%d) ", v1, v2, (int)underflow);
-        if (underflow) {
-            v1 -= 1;
-        }
-        int v3 = v1 - v2;
-        underflow = (v3 < 0);
-        if (underflow) {
-            v3 += 10;
-        }
-        //printf("=> %d\n", v3);
-        result = (char)(v3 + '0') + result;
-    }
+    // 桁の重なる部分をカーネルで引き、残りの上の桁に借りを伝播させる
+    size_t len = minuend_istr_n.length();
+    size_t diff = len - subtrahend_istr_n.length();
+    std::string result(len, '0');
+    int borrow = IntDigits_Sub(minuend_istr_n.data() + diff, subtrahend_istr_n.data(), &result[diff], subtrahend_istr_n.length());
+    IntDigits_SubBorrow(minuend_istr_n.data(), &result[0], diff, borrow);
 
     // 正規化してリターン
     return IntString_Normalize(result);
@@ -118,38 +91,35 @@ std::string IntString_Sub(const std::string& minuend_istr_n, const std::string&
 // 正の整数を表す文字列同士で、掛け算を計算する。
 std::string IntString_Mult(const std::string& istr_n_1, const std::string& istr_n_2)
 {
-    // 各桁ごとに掛け算を計算
-    std::vector<std::string> results;
-    int len2 = (int)istr_n_2.length();
-    for (int i = 0; i < len2; i++) {
-        std::string result = "";
-        for (int j = 0; j < i; j++) {
-            result = result + "0";
-        }
-        int v2 = istr_n_2[len2-i-1] - '0';
-        int overflow = 0;
-        int len1 = (int)istr_n_1.length();
-        for (int j = 0; j < len1; j++) {
-            int v1 = istr_n_1[len1-j-1] - '0';
-            int v3 = v1 * v2 + overflow;
-            overflow = v3 / 10;
-            v3 -= overflow * 10;
-            result = (char)(v3 + '0') + result;
-        }
-        if (overflow > 0) {
-            result = (char)(overflow + '0') + result;
-        }
-        results.push_back(result);
+    // ある程度の桁数がある場合は、リム配列に変換して計算する
+    size_t minDigits = (size_t)std::min(FPTuning::Current().limbsMultMinDigits, kShortMultMaxDigits + 1);
+    if (istr_n_1.length() >= minDigits && istr_n_2.length() >= minDigits) {
+        return IntString_FromLimbs(IntLimbs_Mult(IntString_ToLimbs(istr_n_1), IntString_ToLimbs(istr_n_2)));
     }
 
-    // 結果をすべて足し合わせる
-    std::string resultValue = "0";
-    for (int i = 0; i < results.size(); i++) {
-        resultValue = IntString_Add(resultValue, results[i]);
+    // 短い方（kShortMultMaxDigits桁以下）を1つの整数にして、長い方の下の桁から順に掛けていく
+    const std::string& longer = (istr_n_1.length() >= istr_n_2.length())? istr_n_1: istr_n_2;
+    const std::string& shorter = (istr_n_1.length() >= istr_n_2.length())? istr_n_2: istr_n_1;
+    int mul = 0;
+    for (size_t i = 0; i < shorter.length(); i++) {
+        mul = mul * 10 + (shorter[i] - '0');
+    }
+    size_t len = longer.length();
+    std::string result(len + kShortMultMaxDigits, '0');
+    int overflow = 0;
+    size_t pos = result.length();
+    for (size_t i = len; i-- > 0;) {
+        int v = (longer[i] - '0') * mul + overflow;
+        overflow = v / 10;
+        result[--pos] = (char)('0' + (v - overflow * 10));
+    }
+    while (overflow > 0) {
+        result[--pos] = (char)('0' + overflow % 10);
+        overflow /= 10;
     }
 
     // 正規化してリターンする
-    return IntString_Normalize(resultValue);
+    return IntString_Normalize(result);
 }
 
 // 正の整数を表す文字列同士で、割り算を計算する。
@@ -160,13 +130,21 @@ std::pair<std::string, std::string> IntString_Div(const std::string& dend_istr_n
     if (dor_istr_n == "0") {
         throw std::runtime_error("Zero division is now allowed.");
     }
+    int dend_len = (int)dend_istr_n.length();
+
+    // 長い場合はリム配列に変換して計算する
+    if (dend_len >= FPTuning::Current().divLimbsMinDigits) {
+        std::pair<IntLimbs, IntLimbs> qr = IntLimbs_DivMod(IntString_ToLimbs(dend_istr_n), IntString_ToLimbs(dor_istr_n));
+        return std::make_pair(IntString_FromLimbs(qr.first), IntString_FromLimbs(qr.second));
+    }
 
     // 割り算を計算する
     std::string result_istr = "";
-    int dend_len = (int)dend_istr_n.length();
     int div_pos = 0;
     std::string remain_istr = "";
     while (div_pos < dend_len) {
+        FPComputeContext::CheckPoint();
+
         // 次の割られる数をセット
         remain_istr = (remain_istr != "0"? remain_istr: "") + dend_istr_n.substr(div_pos, 1);
         //printf("1: remain_istr=%s\n", remain_istr.c_str());
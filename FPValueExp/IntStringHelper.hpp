@@ -32,6 +32,7 @@ std::string IntString_Mult(const std::string& istr_n_1, const std::string& istr_
 
 /*!
     正の整数を表す文字列同士で、割り算を計算します。
+    割られる数がプロファイル（FPTuning）で指定された桁数以上ある場合は、リム配列に変換して計算します。
     @param  dend_istr_n 割られる数を表す正規化された整数文字列 (dividend)
     @param  dor_istr_n  割る数を表す正規化された整数文字列 (divisor)
     @return 商(quotient)をfirst, 余り(remainder)をsecondにしたFPValueのペア
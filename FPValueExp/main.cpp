@@ -31,6 +31,10 @@ int main()
         printf("sin=%s\n", FPMath::Sin(angle, 20).c_str());
         printf("cos=%s\n", FPMath::Cos(angle, 20).c_str());
 
+        // 平方根・n乗根の計算
+        printf("sqrt(2)=%s\n", FPMath::Sqrt("2", 40).c_str());
+        printf("root(2, 3)=%s\n", FPMath::Root("2", 3, 40).c_str());
+
     } catch (std::exception& e) {
         printf("Error: %s\n", e.what());
     }